@@ -0,0 +1,415 @@
+/**
+  @file
+  @author Erik Boström <cewbostrom@gmail.com>
+  @date 16.10.2026
+
+  @section LICENSE
+
+  MIT License (MIT)
+
+  Copyright (c) 2015 Erik Boström
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+  @section DESCRIPTION
+
+  Throughput benchmark of BinSerializer and BinDeserializer.
+
+  Runs every combination of data size (256 bytes to 1 GiB by default, in steps of 16)
+  and workload:
+
+    scalar   write and read uint64_t values one at a time
+    bulk     write_span and read of a uint32_t array
+    cstring  write(const char*) of 8 to 40 character strings
+    mixed    write_object and read_object of a struct with integers, a double, a
+             std::string and a std::vector<int>
+
+  encoding with each buffer policy:
+
+    grow       a new BinSerializer with the default 1 KiB capacity, doubling
+    reserve    a new BinSerializer reserved to the size from a BinSizeCounter run,
+               with the counting included in the time
+    reuse      one BinSerializer emptied with reset() between runs
+    pool       a new BinSerializer drawing on BinBufferPool::local()
+    segmented  a new SegmentedBinSerializer with 64 KiB blocks
+
+  and decoding with BinDeserializer. Prints one JSON object per measurement, in a
+  JSON array, with the throughput in GB/s of serialized bytes and ns per item.
+
+  Small sizes are repeated until at least 256 MiB have been processed. Inputs are
+  generated from a fixed seed so runs are comparable.
+
+  build:
+
+    g++ -O2 -std=c++11 -I.. bin_serializer_bench.cpp -o bin_serializer_bench
+
+  usage:
+
+    bin_serializer_bench [--min-bytes N] [--max-bytes N] [--mem-limit MiB]
+      [--workload NAME] [--policy NAME]
+
+  Configurations estimated to need more than --mem-limit (default 4096 MiB) are
+  skipped.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bin_serializer.h"
+#include "bin_object.h"
+
+namespace
+{
+
+struct Record
+{
+  uint32_t id;
+  uint16_t kind;
+  uint16_t flags;
+  double score;
+  std::string name;
+  std::vector<int> tags;
+
+  BIN_FIELDS(id, kind, flags, score, name, tags)
+};
+
+//keeps the optimizer from discarding results
+volatile size_t sink;
+
+struct Sample
+{
+  double nanoseconds = 0;
+  size_t bytes = 0;
+  size_t reps = 0;
+};
+
+template<class F>
+Sample timed(size_t reps, F f)
+{
+  Sample s;
+  s.reps = reps;
+  auto t0 = std::chrono::steady_clock::now();
+  for(size_t r = 0; r < reps; ++r)
+  {
+    size_t bytes = f();
+    s.bytes += bytes;
+  }
+  s.nanoseconds = std::chrono::duration<double, std::nano>(
+    std::chrono::steady_clock::now() - t0).count();
+  return s;
+}
+
+bool first_result = true;
+
+//bytes is the size of the serialized data of one run
+void report(const char* workload, const char* op, const char* policy, size_t items,
+  const Sample& s)
+{
+  size_t bytes = s.bytes / s.reps;
+  double gbps = s.bytes / s.nanoseconds;
+  double ns = s.nanoseconds / (double(items) * s.reps);
+  std::printf("%s  {\"workload\": \"%s\", \"op\": \"%s\", \"policy\": \"%s\", "
+    "\"bytes\": %zu, \"items\": %zu, \"gbps\": %.3f, \"ns_per_item\": %.3f}",
+    first_result? "" : ",\n", workload, op, policy, bytes, items, gbps, ns);
+  first_result = false;
+  std::fflush(stdout);
+}
+
+//workloads: the data to write, how to write it with any writer and how to read it
+
+struct Scalar
+{
+  static const char* name(){return "scalar";}
+  static size_t item_size(){return 8;}
+
+  std::vector<uint64_t> values;
+
+  Scalar(size_t items, std::mt19937_64& rng)
+  {
+    values.reserve(items);
+    for(size_t i = 0; i < items; ++i)
+      values.push_back(rng());
+  }
+  size_t items() const {return values.size();}
+
+  template<class W>
+  void write(W& w) const
+  {
+    for(uint64_t v: values)
+      w.write(v);
+  }
+  size_t read(BinDeserializer& d) const
+  {
+    size_t acc = 0;
+    for(size_t i = 0; i < values.size(); ++i)
+      acc += d.read<uint64_t>();
+    return acc;
+  }
+};
+
+struct Bulk
+{
+  static const char* name(){return "bulk";}
+  static size_t item_size(){return 4;}
+
+  std::vector<uint32_t> values;
+
+  Bulk(size_t items, std::mt19937_64& rng)
+  {
+    values.reserve(items);
+    for(size_t i = 0; i < items; ++i)
+      values.push_back(uint32_t(rng()));
+  }
+  size_t items() const {return values.size();}
+
+  template<class W>
+  void write(W& w) const
+  {
+    w.write_span(values.data(), values.size());
+  }
+  size_t read(BinDeserializer& d) const
+  {
+    std::vector<uint32_t> out(values.size());
+    d.read(out.data(), out.size());
+    return out.empty()? 0 : out[0];
+  }
+};
+
+struct CString
+{
+  static const char* name(){return "cstring";}
+  static size_t item_size(){return 24;}
+
+  std::vector<std::string> values;
+
+  CString(size_t items, std::mt19937_64& rng)
+  {
+    values.reserve(items);
+    for(size_t i = 0; i < items; ++i)
+    {
+      std::string s(8 + rng() % 33, 'a');
+      for(auto& c: s)
+        c = char('a' + rng() % 26);
+      values.push_back(std::move(s));
+    }
+  }
+  size_t items() const {return values.size();}
+
+  template<class W>
+  void write(W& w) const
+  {
+    for(const std::string& s: values)
+      w.write(s.c_str());
+  }
+  size_t read(BinDeserializer& d) const
+  {
+    //the strings have no terminator or length, so read them back by their known size
+    char buffer[64];
+    size_t acc = 0;
+    for(const std::string& s: values)
+    {
+      d.read(buffer, s.size());
+      acc += buffer[0];
+    }
+    return acc;
+  }
+};
+
+struct Mixed
+{
+  static const char* name(){return "mixed";}
+  static size_t item_size(){return 64;}
+
+  std::vector<Record> values;
+
+  Mixed(size_t items, std::mt19937_64& rng)
+  {
+    values.resize(items);
+    for(Record& r: values)
+    {
+      r.id = uint32_t(rng());
+      r.kind = uint16_t(rng() % 16);
+      r.flags = uint16_t(rng());
+      r.score = std::uniform_real_distribution<double>()(rng);
+      r.name.assign(4 + rng() % 20, char('a' + rng() % 26));
+      r.tags.resize(rng() % 8);
+      for(int& t: r.tags)
+        t = int(rng() % 1000);
+    }
+  }
+  size_t items() const {return values.size();}
+
+  template<class W>
+  void write(W& w) const
+  {
+    for(const Record& r: values)
+      w.write_object(r);
+  }
+  size_t read(BinDeserializer& d) const
+  {
+    Record r;
+    size_t acc = 0;
+    for(size_t i = 0; i < values.size(); ++i)
+    {
+      d.read_object(r);
+      acc += r.id;
+    }
+    return acc;
+  }
+};
+
+struct Options
+{
+  size_t min_bytes = 256;
+  size_t max_bytes = size_t(1) << 30;
+  size_t mem_limit = size_t(4096) << 20;
+  const char* workload = nullptr;
+  const char* policy = nullptr;
+};
+
+bool selected(const char* filter, const char* name)
+{
+  return filter == nullptr || std::strcmp(filter, name) == 0;
+}
+
+template<class W>
+void bench_encode(const Options& opt, const W& work, size_t reps)
+{
+  const char* name = W::name();
+  size_t items = work.items();
+
+  if(selected(opt.policy, "grow"))
+    report(name, "encode", "grow", items, timed(reps, [&]{
+      BinSerializer s;
+      work.write(s);
+      return size_t(s.size());
+    }));
+  if(selected(opt.policy, "reserve"))
+    report(name, "encode", "reserve", items, timed(reps, [&]{
+      BinSizeCounter counter;
+      work.write(counter);
+      BinSerializer s(0);
+      s.reserve(counter.capacity());
+      work.write(s);
+      return size_t(s.size());
+    }));
+  if(selected(opt.policy, "reuse"))
+  {
+    BinSerializer s;
+    report(name, "encode", "reuse", items, timed(reps, [&]{
+      s.reset();
+      work.write(s);
+      return size_t(s.size());
+    }));
+  }
+  if(selected(opt.policy, "pool"))
+    report(name, "encode", "pool", items, timed(reps, [&]{
+      BinSerializer s(BinBufferPool::local());
+      work.write(s);
+      return size_t(s.size());
+    }));
+  if(selected(opt.policy, "segmented"))
+    report(name, "encode", "segmented", items, timed(reps, [&]{
+      SegmentedBinSerializer s;
+      work.write(s);
+      return size_t(s.size());
+    }));
+}
+
+template<class W>
+void bench_workload(const Options& opt)
+{
+  if(!selected(opt.workload, W::name()))
+    return;
+
+  for(size_t bytes = opt.min_bytes; bytes <= opt.max_bytes; bytes *= 16)
+  {
+    //input, encoded copy and the serializer being written
+    if(bytes * 4 > opt.mem_limit)
+      continue;
+
+    std::mt19937_64 rng(bytes);
+    size_t items = (bytes + W::item_size() - 1) / W::item_size();
+    W work(items, rng);
+    size_t reps = ((size_t(256) << 20) + bytes - 1) / bytes;
+
+    bench_encode(opt, work, reps);
+
+    BinSerializer encoded;
+    work.write(encoded);
+    size_t size = encoded.size();
+    report(W::name(), "decode", "-", items, timed(reps, [&]{
+      BinDeserializer d(encoded.get(), size);
+      sink = work.read(d);
+      return size;
+    }));
+  }
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  Options opt;
+  for(int i = 1; i + 1 < argc; i += 2)
+  {
+    if(std::strcmp(argv[i], "--min-bytes") == 0)
+      opt.min_bytes = std::strtoull(argv[i + 1], nullptr, 10);
+    else if(std::strcmp(argv[i], "--max-bytes") == 0)
+      opt.max_bytes = std::strtoull(argv[i + 1], nullptr, 10);
+    else if(std::strcmp(argv[i], "--mem-limit") == 0)
+      opt.mem_limit = std::strtoull(argv[i + 1], nullptr, 10) << 20;
+    else if(std::strcmp(argv[i], "--workload") == 0)
+      opt.workload = argv[i + 1];
+    else if(std::strcmp(argv[i], "--policy") == 0)
+      opt.policy = argv[i + 1];
+    else
+    {
+      std::fprintf(stderr, "unknown option %s\n", argv[i]);
+      return 1;
+    }
+  }
+  if(opt.min_bytes == 0)
+    opt.min_bytes = 1;
+
+  //warm up the allocator and the cpu clock before the first measurement
+  {
+    std::mt19937_64 rng(0);
+    Bulk warmup(size_t(1) << 22, rng);
+    for(int i = 0; i < 4; ++i)
+    {
+      BinSerializer s;
+      warmup.write(s);
+      sink = s.size();
+    }
+  }
+
+  std::printf("[\n");
+  bench_workload<Scalar>(opt);
+  bench_workload<Bulk>(opt);
+  bench_workload<CString>(opt);
+  bench_workload<Mixed>(opt);
+  std::printf("\n]\n");
+  return 0;
+}
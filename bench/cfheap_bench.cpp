@@ -0,0 +1,458 @@
+/**
+  @file
+  @author Erik Boström <cewbostrom@gmail.com>
+  @date 16.10.2026
+
+  @section LICENSE
+
+  MIT License (MIT)
+
+  Copyright (c) 2015 Erik Boström
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+
+  @section DESCRIPTION
+
+  Benchmark of CFHeap against std::priority_queue.
+
+  Runs every combination of heap size (1e2 to 1e8 by default), element type (int,
+  double, a 64 byte struct and std::string) and workload:
+
+    push     push n elements into an empty heap
+    pop      pop all elements from a heap of n elements
+    mixed    pop and push n times on a heap kept at n elements
+    heapify  build a heap from n unordered elements
+
+  and prints ns/op for both implementations. On Linux the number of last level cache
+  misses per op is printed as well when hardware counters are available.
+
+  Small sizes are repeated until at least a million operations have been timed. Inputs
+  are generated from a fixed seed so runs are comparable.
+
+  build:
+
+    g++ -O2 -std=c++11 -I.. cfheap_bench.cpp -o cfheap_bench
+
+  usage:
+
+    cfheap_bench [--min-size N] [--max-size N] [--mem-limit MiB] [--type NAME]
+      [--workload NAME]
+
+  Configurations estimated to need more than --mem-limit (default 4096 MiB) are
+  skipped.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <chrono>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "cfheap.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+struct Payload64
+{
+  uint64_t key;
+  char data[56];
+
+  bool operator<(const Payload64& other) const
+  {return key < other.key;}
+  bool operator>(const Payload64& other) const
+  {return key > other.key;}
+};
+
+//counts last level cache misses of this thread, if the kernel lets us
+class CacheMissCounter
+{
+  int _fd = -1;
+
+public:
+  CacheMissCounter()
+  {
+#ifdef __linux__
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    _fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+  }
+  CacheMissCounter(const CacheMissCounter&) = delete;
+  void operator=(const CacheMissCounter&) = delete;
+  ~CacheMissCounter()
+  {
+#ifdef __linux__
+    if(_fd >= 0)
+      close(_fd);
+#endif
+  }
+
+  bool available() const
+  {
+    return _fd >= 0;
+  }
+
+  void start()
+  {
+#ifdef __linux__
+    if(_fd < 0) return;
+    ioctl(_fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(_fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+  }
+
+  long long stop()
+  {
+#ifdef __linux__
+    if(_fd < 0) return 0;
+    ioctl(_fd, PERF_EVENT_IOC_DISABLE, 0);
+    long long count = 0;
+    if(read(_fd, &count, sizeof(count)) != sizeof(count))
+      return 0;
+    return count;
+#else
+    return 0;
+#endif
+  }
+};
+
+CacheMissCounter* counter;
+
+struct Sample
+{
+  double nanoseconds = 0;
+  long long misses = 0;
+  size_t ops = 0;
+
+  void add(std::chrono::steady_clock::duration d, long long m, size_t o)
+  {
+    nanoseconds += std::chrono::duration<double, std::nano>(d).count();
+    misses += m;
+    ops += o;
+  }
+};
+
+template<class F>
+void timed(Sample& sample, size_t ops, F f)
+{
+  auto t0 = std::chrono::steady_clock::now();
+  counter->start();
+  f();
+  long long misses = counter->stop();
+  sample.add(std::chrono::steady_clock::now() - t0, misses, ops);
+}
+
+template<class T> const char* type_name();
+template<> const char* type_name<int>(){return "int";}
+template<> const char* type_name<double>(){return "double";}
+template<> const char* type_name<Payload64>(){return "payload64";}
+template<> const char* type_name<std::string>(){return "string";}
+
+//rough number of bytes needed per element, input copy and heap together
+template<class T> size_t footprint(){return sizeof(T) * 4;}
+template<> size_t footprint<std::string>(){return (sizeof(std::string) + 32) * 4;}
+
+template<class T> T make_value(std::mt19937_64& rng);
+template<> int make_value<int>(std::mt19937_64& rng)
+{return (int)(rng() >> 33);}
+template<> double make_value<double>(std::mt19937_64& rng)
+{return std::uniform_real_distribution<double>()(rng);}
+template<> Payload64 make_value<Payload64>(std::mt19937_64& rng)
+{
+  Payload64 p;
+  p.key = rng();
+  memset(p.data, (int)(p.key & 0xff), sizeof(p.data));
+  return p;
+}
+template<> std::string make_value<std::string>(std::mt19937_64& rng)
+{
+  //long enough to defeat the small string optimization
+  std::string s(24, 'a');
+  for(auto& c: s)
+    c = char('a' + rng() % 26);
+  return s;
+}
+
+//heap interface adapters
+
+template<class T>
+struct StdHeap
+{
+  std::priority_queue<T> q;
+
+  StdHeap(){}
+  StdHeap(const T* b, const T* e): q(b, e){}
+  static const char* name(){return "std";}
+  void push(const T& v){q.push(v);}
+  void pop(){q.pop();}
+  const T& top(){return q.top();}
+  bool empty(){return q.empty();}
+};
+
+template<class T>
+struct CFHeapAdapter
+{
+  CFHeap<T> q;
+
+  CFHeapAdapter(){}
+  CFHeapAdapter(const T* b, const T* e): q(b, e){}
+  static const char* name(){return "cfheap";}
+  void push(const T& v){q.push(v);}
+  void pop(){q.pop();}
+  const T& top(){return q.top();}
+  bool empty(){return q.empty();}
+};
+
+//keeps the optimizer from discarding results
+volatile size_t sink;
+
+size_t touch(int v){return (size_t)v;}
+size_t touch(double v){return (size_t)v;}
+size_t touch(const Payload64& v){return (size_t)v.key;}
+size_t touch(const std::string& v){return (size_t)v[0];}
+
+//small sizes are run reps times over separate heaps inside a single timed region, so
+//that the cost of reading the clock and the counters does not show up per op
+
+template<class H, class T>
+Sample run_push(const std::vector<T>& input, size_t reps)
+{
+  Sample s;
+  std::vector<H> heaps(reps);
+  timed(s, input.size() * reps, [&]{
+    for(H& h: heaps)
+      for(const T& v: input)
+        h.push(v);
+  });
+  return s;
+}
+
+template<class H, class T>
+Sample run_pop(const std::vector<T>& input, size_t reps)
+{
+  Sample s;
+  std::vector<H> heaps;
+  heaps.reserve(reps);
+  for(size_t r = 0; r < reps; ++r)
+    heaps.emplace_back(input.data(), input.data() + input.size());
+  timed(s, input.size() * reps, [&]{
+    size_t acc = 0;
+    for(H& h: heaps)
+    {
+      while(!h.empty())
+      {
+        acc += touch(h.top());
+        h.pop();
+      }
+    }
+    sink = acc;
+  });
+  return s;
+}
+
+template<class H, class T>
+Sample run_mixed(const std::vector<T>& input, const std::vector<T>& extra, size_t reps)
+{
+  Sample s;
+  H h(input.data(), input.data() + input.size());
+  timed(s, extra.size() * 2 * reps, [&]{
+    size_t acc = 0;
+    for(size_t r = 0; r < reps; ++r)
+    {
+      for(const T& v: extra)
+      {
+        acc += touch(h.top());
+        h.pop();
+        h.push(v);
+      }
+    }
+    sink = acc;
+  });
+  return s;
+}
+
+template<class H, class T>
+Sample run_heapify(const std::vector<T>& input, size_t reps)
+{
+  Sample s;
+  std::vector<H> heaps;
+  heaps.reserve(reps);
+  timed(s, input.size() * reps, [&]{
+    size_t acc = 0;
+    for(size_t r = 0; r < reps; ++r)
+    {
+      heaps.emplace_back(input.data(), input.data() + input.size());
+      acc += touch(heaps.back().top());
+    }
+    sink = acc;
+  });
+  return s;
+}
+
+void report(const char* type, const char* workload, size_t n, const char* impl,
+  const Sample& s, double baseline)
+{
+  double ns = s.nanoseconds / s.ops;
+  std::printf("%-10s %-8s %10zu %-7s %10.2f", type, workload, n, impl, ns);
+  if(counter->available())
+    std::printf(" %12.3f", double(s.misses) / s.ops);
+  else std::printf(" %12s", "-");
+  if(baseline > 0)
+    std::printf(" %8.3f", baseline / ns);
+  else std::printf(" %8s", "");
+  std::printf("\n");
+  std::fflush(stdout);
+}
+
+struct Options
+{
+  size_t min_size = 100;
+  size_t max_size = 100000000;
+  size_t mem_limit = size_t(4096) << 20;
+  const char* type = nullptr;
+  const char* workload = nullptr;
+};
+
+bool selected(const char* filter, const char* name)
+{
+  return filter == nullptr || std::strcmp(filter, name) == 0;
+}
+
+template<class T>
+void bench_type(const Options& opt)
+{
+  if(!selected(opt.type, type_name<T>()))
+    return;
+
+  for(size_t n = opt.min_size; n <= opt.max_size; n *= 10)
+  {
+    if(n * footprint<T>() > opt.mem_limit)
+    {
+      std::printf("%-10s %-8s %10zu skipped, exceeds memory limit\n",
+        type_name<T>(), "*", n);
+      continue;
+    }
+
+    std::mt19937_64 rng(n);
+    std::vector<T> input, extra;
+    input.reserve(n);
+    extra.reserve(n);
+    for(size_t i = 0; i < n; ++i)
+      input.push_back(make_value<T>(rng));
+    for(size_t i = 0; i < n; ++i)
+      extra.push_back(make_value<T>(rng));
+
+    size_t reps = (1000000 + n - 1) / n;
+
+    if(selected(opt.workload, "push"))
+    {
+      Sample a = run_push<StdHeap<T>>(input, reps);
+      Sample b = run_push<CFHeapAdapter<T>>(input, reps);
+      report(type_name<T>(), "push", n, StdHeap<T>::name(), a, 0);
+      report(type_name<T>(), "push", n, CFHeapAdapter<T>::name(), b, a.nanoseconds / a.ops);
+    }
+    if(selected(opt.workload, "pop"))
+    {
+      Sample a = run_pop<StdHeap<T>>(input, reps);
+      Sample b = run_pop<CFHeapAdapter<T>>(input, reps);
+      report(type_name<T>(), "pop", n, StdHeap<T>::name(), a, 0);
+      report(type_name<T>(), "pop", n, CFHeapAdapter<T>::name(), b, a.nanoseconds / a.ops);
+    }
+    if(selected(opt.workload, "mixed"))
+    {
+      Sample a = run_mixed<StdHeap<T>>(input, extra, reps);
+      Sample b = run_mixed<CFHeapAdapter<T>>(input, extra, reps);
+      report(type_name<T>(), "mixed", n, StdHeap<T>::name(), a, 0);
+      report(type_name<T>(), "mixed", n, CFHeapAdapter<T>::name(), b, a.nanoseconds / a.ops);
+    }
+    if(selected(opt.workload, "heapify"))
+    {
+      Sample a = run_heapify<StdHeap<T>>(input, reps);
+      Sample b = run_heapify<CFHeapAdapter<T>>(input, reps);
+      report(type_name<T>(), "heapify", n, StdHeap<T>::name(), a, 0);
+      report(type_name<T>(), "heapify", n, CFHeapAdapter<T>::name(), b, a.nanoseconds / a.ops);
+    }
+  }
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  Options opt;
+  for(int i = 1; i + 1 < argc; i += 2)
+  {
+    if(std::strcmp(argv[i], "--min-size") == 0)
+      opt.min_size = std::strtoull(argv[i + 1], nullptr, 10);
+    else if(std::strcmp(argv[i], "--max-size") == 0)
+      opt.max_size = std::strtoull(argv[i + 1], nullptr, 10);
+    else if(std::strcmp(argv[i], "--mem-limit") == 0)
+      opt.mem_limit = std::strtoull(argv[i + 1], nullptr, 10) << 20;
+    else if(std::strcmp(argv[i], "--type") == 0)
+      opt.type = argv[i + 1];
+    else if(std::strcmp(argv[i], "--workload") == 0)
+      opt.workload = argv[i + 1];
+    else
+    {
+      std::fprintf(stderr, "unknown option %s\n", argv[i]);
+      return 1;
+    }
+  }
+  if(opt.min_size == 0)
+    opt.min_size = 1;
+
+  CacheMissCounter c;
+  counter = &c;
+
+  //warm up the allocator and the cpu clock before the first measurement
+  {
+    std::mt19937_64 rng(0);
+    std::vector<int> warmup;
+    for(int i = 0; i < 1000000; ++i)
+      warmup.push_back(make_value<int>(rng));
+    run_push<StdHeap<int>>(warmup, 4);
+    run_push<CFHeapAdapter<int>>(warmup, 4);
+  }
+
+  std::printf("%-10s %-8s %10s %-7s %10s %12s %8s\n",
+    "type", "workload", "size", "impl", "ns/op", "misses/op", "speedup");
+  bench_type<int>(opt);
+  bench_type<double>(opt);
+  bench_type<Payload64>(opt);
+  bench_type<std::string>(opt);
+  return 0;
+}
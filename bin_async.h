@@ -0,0 +1,540 @@
+#ifndef BIN_ASYNC_H_INCLUDED
+#define BIN_ASYNC_H_INCLUDED
+
+/**
+  @file
+  @author Erik Boström <cewbostrom@gmail.com>
+  @date 16.10.2026
+
+  @section LICENSE
+
+  MIT License (MIT)
+
+  Copyright (c) 2015 Erik Boström
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+
+  @section DESCRIPTION
+
+  A serializer that writes to a file descriptor in the background, so that the thread
+  producing the data does not wait for the disk. POSIX only.
+
+  The data is written into one of a small set of fixed-size buffers. When a buffer
+  fills it is queued for writing and the producer carries on in the next free one. If
+  every buffer is queued the producer waits, which bounds both memory use and how far
+  the producer can run ahead of the disk.
+
+  The buffers are written by a background thread. On Linux, defining
+  BIN_ASYNC_IO_URING before including this file makes the writer submit the buffers to
+  an io_uring instead, with no extra thread. This needs Linux 5.6 or later and a
+  seekable file, otherwise the writer falls back to the thread.
+
+  usage:
+
+  BinAsyncWriter has the write functions of BinSerializer. Call flush() to wait until
+  everything written so far is on its way to the file, or let the destructor do it.
+*/
+
+#include <memory>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstring>
+#include <cstdint>
+#include <cerrno>
+
+#include <unistd.h>
+
+#if defined(BIN_ASYNC_IO_URING) && defined(__linux__)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#define BIN_ASYNC_HAS_IO_URING
+#endif
+
+#include "bin_serializer.h"
+
+#ifdef BIN_ASYNC_HAS_IO_URING
+//a minimal io_uring used by BinAsyncWriter to submit writes without a thread
+class __BinUring
+{
+  int _fd = -1;
+  void* _sq_ptr = MAP_FAILED;
+  void* _cq_ptr = MAP_FAILED;
+  size_t _sq_size = 0;
+  size_t _cq_size = 0;
+  struct io_uring_sqe* _sqes = (struct io_uring_sqe*)MAP_FAILED;
+  size_t _sqes_size = 0;
+
+  unsigned* _sq_tail;
+  unsigned* _sq_mask;
+  unsigned* _sq_array;
+  unsigned* _cq_head;
+  unsigned* _cq_tail;
+  unsigned* _cq_mask;
+  struct io_uring_cqe* _cqes;
+
+public:
+  __BinUring(unsigned entries)
+  {
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    _fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+    if(_fd < 0)
+      return;
+
+    _sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    _cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if(p.features & IORING_FEAT_SINGLE_MMAP)
+      _sq_size = _cq_size = _sq_size > _cq_size? _sq_size : _cq_size;
+    _sq_ptr = mmap(nullptr, _sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+      _fd, IORING_OFF_SQ_RING);
+    if(_sq_ptr == MAP_FAILED)
+      return;
+    if(p.features & IORING_FEAT_SINGLE_MMAP)
+      _cq_ptr = _sq_ptr;
+    else
+    {
+      _cq_ptr = mmap(nullptr, _cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+        _fd, IORING_OFF_CQ_RING);
+      if(_cq_ptr == MAP_FAILED)
+        return;
+    }
+    _sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+    _sqes = (struct io_uring_sqe*)mmap(nullptr, _sqes_size, PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQES);
+    if(_sqes == MAP_FAILED)
+      return;
+
+    char* sq = (char*)_sq_ptr;
+    char* cq = (char*)_cq_ptr;
+    _sq_tail = (unsigned*)(sq + p.sq_off.tail);
+    _sq_mask = (unsigned*)(sq + p.sq_off.ring_mask);
+    _sq_array = (unsigned*)(sq + p.sq_off.array);
+    _cq_head = (unsigned*)(cq + p.cq_off.head);
+    _cq_tail = (unsigned*)(cq + p.cq_off.tail);
+    _cq_mask = (unsigned*)(cq + p.cq_off.ring_mask);
+    _cqes = (struct io_uring_cqe*)(cq + p.cq_off.cqes);
+  }
+  __BinUring(const __BinUring&) = delete;
+  void operator=(const __BinUring&) = delete;
+  ~__BinUring()
+  {
+    if(_sqes != MAP_FAILED)
+      munmap(_sqes, _sqes_size);
+    if(_cq_ptr != MAP_FAILED && _cq_ptr != _sq_ptr)
+      munmap(_cq_ptr, _cq_size);
+    if(_sq_ptr != MAP_FAILED)
+      munmap(_sq_ptr, _sq_size);
+    if(_fd >= 0)
+      close(_fd);
+  }
+
+  bool good() const
+  {
+    return _sqes != MAP_FAILED;
+  }
+
+  //queues a write and submits it. the caller makes sure the ring never holds more
+  //writes than it has entries
+  bool write(int fd, const char* data, uintptr_t len, uint64_t offset, uint64_t user)
+  {
+    unsigned tail = *_sq_tail;
+    unsigned index = tail & *_sq_mask;
+    struct io_uring_sqe* sqe = _sqes + index;
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_WRITE;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t)data;
+    sqe->len = (unsigned)len;
+    sqe->off = offset;
+    sqe->user_data = user;
+    _sq_array[index] = index;
+    __atomic_store_n(_sq_tail, tail + 1, __ATOMIC_RELEASE);
+    for(;;)
+    {
+      long n = syscall(__NR_io_uring_enter, _fd, 1, 0, 0, nullptr, 0);
+      if(n >= 0)
+        return true;
+      if(errno != EINTR && errno != EAGAIN)
+        return false;
+    }
+  }
+
+  //waits for at least one completion and calls f(user, result) for each one
+  template<class F>
+  bool reap(F f)
+  {
+    unsigned head = *_cq_head;
+    while(head == __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE))
+    {
+      long n = syscall(__NR_io_uring_enter, _fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+      if(n < 0 && errno != EINTR)
+        return false;
+    }
+    unsigned tail = __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE);
+    for(; head != tail; ++head)
+    {
+      struct io_uring_cqe& cqe = _cqes[head & *_cq_mask];
+      uint64_t user = cqe.user_data;
+      int res = cqe.res;
+      __atomic_store_n(_cq_head, head + 1, __ATOMIC_RELEASE);
+      f(user, res);
+    }
+    return true;
+  }
+};
+#endif
+
+/**
+  @brief Serializer that hands full buffers to the background to be written.
+
+  Writes of contiguous memory larger than a buffer are split across buffers, so no
+  buffer grows beyond its size unless a single encoded integer block does not fit.
+*/
+class BinAsyncWriter: public BinWriter<BinAsyncWriter>
+{
+  friend class BinWriter<BinAsyncWriter>;
+
+  struct __Buffer
+  {
+    std::unique_ptr<char[]> data;
+    uintptr_t capacity;
+    uintptr_t size = 0;
+    uintptr_t done = 0;
+    uint64_t offset = 0;
+
+    __Buffer(uintptr_t cap): data(new char[cap]), capacity(cap){}
+  };
+
+  int _fd;
+  std::vector<std::unique_ptr<__Buffer>> _buffers;
+  std::vector<__Buffer*> _free;
+  __Buffer* _current;
+  uint64_t _handed = 0;
+  uint64_t _start;
+  uintptr_t _stalls = 0;
+  std::atomic<bool> _good;
+
+  std::deque<__Buffer*> _queue;
+  std::mutex _mutex;
+  std::condition_variable _cv_work;
+  std::condition_variable _cv_free;
+  std::thread _thread;
+  bool _stop = false;
+
+#ifdef BIN_ASYNC_HAS_IO_URING
+  std::unique_ptr<__BinUring> _uring;
+  unsigned _in_flight = 0;
+#endif
+
+  bool _writeAll(const char* data, uintptr_t len)
+  {
+    while(len > 0)
+    {
+      ssize_t n = ::write(_fd, data, len);
+      if(n < 0)
+      {
+        if(errno == EINTR)
+          continue;
+        return false;
+      }
+      data += n;
+      len -= n;
+    }
+    return true;
+  }
+
+  void _run()
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    for(;;)
+    {
+      _cv_work.wait(lock, [this]{return _stop || !_queue.empty();});
+      if(_queue.empty())
+        return;
+      __Buffer* buf = _queue.front();
+      lock.unlock();
+      bool ok = _good && _writeAll(buf->data.get(), buf->size);
+      lock.lock();
+      if(!ok)
+        _good = false;
+      buf->size = 0;
+      _queue.pop_front();
+      _free.push_back(buf);
+      _cv_free.notify_all();
+    }
+  }
+
+#ifdef BIN_ASYNC_HAS_IO_URING
+  //waits for io_uring completions, resubmitting the rest of short writes
+  void _reap()
+  {
+    bool ok = _uring->reap([this](uint64_t user, int res)
+    {
+      __Buffer* buf = _buffers[user].get();
+      if(res > 0)
+        buf->done += res;
+      if(res > 0 && buf->done < buf->size && _good)
+      {
+        if(_uring->write(_fd, buf->data.get() + buf->done, buf->size - buf->done,
+          buf->offset + buf->done, user))
+          return;
+      }
+      if(res <= 0 && buf->done < buf->size)
+        _good = false;
+      buf->size = 0;
+      buf->done = 0;
+      --_in_flight;
+      _free.push_back(buf);
+    });
+    if(!ok)
+    {
+      //the ring is unusable, the buffers in flight are lost
+      _good = false;
+      for(auto& buf: _buffers)
+        if(buf.get() != _current && buf->size != 0)
+        {
+          buf->size = 0;
+          _free.push_back(buf.get());
+        }
+      _in_flight = 0;
+    }
+  }
+#endif
+
+  //queues the current buffer for writing
+  void _submit()
+  {
+    __Buffer* buf = _current;
+    buf->offset = _start + _handed;
+    _handed += buf->size;
+#ifdef BIN_ASYNC_HAS_IO_URING
+    if(_uring)
+    {
+      uint64_t user = 0;
+      while(_buffers[user].get() != buf)
+        ++user;
+      buf->done = 0;
+      if(_good && _uring->write(_fd, buf->data.get(), buf->size, buf->offset, user))
+        ++_in_flight;
+      else
+      {
+        _good = false;
+        buf->size = 0;
+        _free.push_back(buf);
+      }
+      return;
+    }
+#endif
+    std::lock_guard<std::mutex> lock(_mutex);
+    _queue.push_back(buf);
+    _cv_work.notify_one();
+  }
+
+  //takes a free buffer, waiting for one if all of them are queued
+  __Buffer* _acquire()
+  {
+#ifdef BIN_ASYNC_HAS_IO_URING
+    if(_uring)
+    {
+      if(_free.empty())
+        ++_stalls;
+      while(_free.empty())
+        _reap();
+      __Buffer* buf = _free.back();
+      _free.pop_back();
+      return buf;
+    }
+#endif
+    std::unique_lock<std::mutex> lock(_mutex);
+    if(_free.empty())
+    {
+      ++_stalls;
+      _cv_free.wait(lock, [this]{return !_free.empty();});
+    }
+    __Buffer* buf = _free.back();
+    _free.pop_back();
+    return buf;
+  }
+
+  void _next()
+  {
+    _submit();
+    _current = _acquire();
+  }
+
+  char* _prepare(uintptr_t len)
+  {
+    if(_current->capacity - _current->size < len)
+    {
+      if(_current->size != 0)
+        _next();
+      if(_current->capacity < len)
+      {
+        _current->data.reset(new char[len]);
+        _current->capacity = len;
+      }
+    }
+    return _current->data.get() + _current->size;
+  }
+
+  void _advance(uintptr_t len)
+  {
+    _current->size += len;
+  }
+
+  void _writeBytes(const void* data, uintptr_t len)
+  {
+    const char* src = (const char*)data;
+    for(;;)
+    {
+      uintptr_t n = _current->capacity - _current->size;
+      if(n > len)
+        n = len;
+      memcpy(_current->data.get() + _current->size, src, n);
+      _current->size += n;
+      src += n;
+      len -= n;
+      if(len == 0)
+        return;
+      _next();
+    }
+  }
+
+public:
+  /**
+    @brief Constructor
+    @param fd File descriptor to write to. It is not closed by the writer.
+    @param buffer_size Size of each buffer in bytes. default: 1 MiB
+    @param buffers Number of buffers, at least 2. Two buffers let the producer fill one
+    while the other is written, a third absorbs bursts. default: 2
+  */
+  BinAsyncWriter(int fd, uintptr_t buffer_size = uintptr_t(1) << 20, int buffers = 2):
+    _fd(fd),
+    _good(true)
+  {
+    if(buffer_size < 4096)
+      buffer_size = 4096;
+    if(buffers < 2)
+      buffers = 2;
+    for(int i = 0; i < buffers; ++i)
+    {
+      _buffers.emplace_back(new __Buffer(buffer_size));
+      _free.push_back(_buffers.back().get());
+    }
+    _current = _acquire();
+
+    off_t start = lseek(fd, 0, SEEK_CUR);
+    _start = start < 0? 0 : uint64_t(start);
+#ifdef BIN_ASYNC_HAS_IO_URING
+    if(start >= 0)
+    {
+      _uring.reset(new __BinUring(unsigned(buffers)));
+      if(!_uring->good())
+        _uring.reset();
+    }
+    if(!_uring)
+#endif
+    _thread = std::thread(&BinAsyncWriter::_run, this);
+  }
+  BinAsyncWriter(const BinAsyncWriter&) = delete;
+  void operator=(const BinAsyncWriter&) = delete;
+  ~BinAsyncWriter()
+  {
+    flush();
+    if(_thread.joinable())
+    {
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+      }
+      _cv_work.notify_one();
+      _thread.join();
+    }
+  }
+
+  /**
+    @brief Writes everything written so far and waits until it has been written.
+    @return false if a write has failed.
+  */
+  bool flush()
+  {
+    if(_current->size != 0)
+      _next();
+#ifdef BIN_ASYNC_HAS_IO_URING
+    if(_uring)
+    {
+      while(_in_flight != 0)
+        _reap();
+      //io_uring writes at explicit offsets and leaves the file offset alone
+      lseek(_fd, off_t(_start + _handed), SEEK_SET);
+      return _good;
+    }
+#endif
+    std::unique_lock<std::mutex> lock(_mutex);
+    _cv_free.wait(lock, [this]{return _queue.empty();});
+    return _good;
+  }
+
+  /**
+    @brief Returns the number of bytes written, including those not yet on disk.
+  */
+  uintptr_t tell() const
+  {
+    return uintptr_t(_handed + _current->size);
+  }
+  uintptr_t size() const
+  {
+    return tell();
+  }
+
+  /**
+    @brief Returns false if a write to the file descriptor has failed.
+  */
+  bool good() const
+  {
+    return _good;
+  }
+
+  /**
+    @brief Returns the number of times the producer had to wait for a free buffer.
+  */
+  uintptr_t stalls() const
+  {
+    return _stalls;
+  }
+
+  /**
+    @brief Returns true if the writer submits its buffers through io_uring.
+  */
+  bool uring() const
+  {
+#ifdef BIN_ASYNC_HAS_IO_URING
+    return bool(_uring);
+#else
+    return false;
+#endif
+  }
+};
+
+#endif
@@ -0,0 +1,556 @@
+#ifndef BIN_BLOCK_H_INCLUDED
+#define BIN_BLOCK_H_INCLUDED
+
+/**
+  @file
+  @author Erik Boström <cewbostrom@gmail.com>
+  @date 16.10.2026
+
+  @section LICENSE
+
+  MIT License (MIT)
+
+  Copyright (c) 2015 Erik Boström
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+
+  @section DESCRIPTION
+
+  A compression stage for the binary writers and readers. The data is cut into blocks
+  of a fixed size, which are compressed with bin_lz_compress as they fill and written
+  to another writer. Blocks that do not compress are stored as they are. An index of
+  the blocks at the end of the data lets a reader decompress any block on its own, so
+  seeking to a position only costs decompressing the block it is in.
+
+  layout, all integers in host byte order:
+
+  blocks, then for each block its offset (uint64_t), size (uint32_t, high bit set if
+  stored uncompressed) and, with bin_block_crc, the CRC32C of its stored bytes
+  (uint32_t), then a footer of the offset of the index (uint64_t), the size of the
+  uncompressed data (uint64_t), the block size (uint32_t), the number of blocks
+  (uint32_t), the flags (uint32_t) and bin_block_magic (uint32_t). Offsets are
+  relative to the start of the first block.
+
+  With bin_block_crc the checksum of each block is computed right after the block is
+  compressed, while it is still in cache, and checked by the reader only when it
+  decompresses that block, so integrity checking needs no extra pass over the data.
+
+  usage:
+
+  BinBlockWriter wraps any writer, such as a BinSerializer or a BinStreamWriter, and
+  has the same write functions. Call finish() to write the last block and the index,
+  or let the destructor do it. BinBlockReader reads the result from memory, for
+  example from a BinMappedReader or the buffer of a BinSerializer.
+*/
+
+#include <memory>
+#include <type_traits>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+
+#include "bin_serializer.h"
+
+/**
+  @brief Last word of a block compressed stream.
+*/
+const uint32_t bin_block_magic = 0x314b4c42;
+
+/**
+  @brief Size in bytes of the footer of a block compressed stream.
+*/
+const uintptr_t bin_block_footer_size = 32;
+
+/**
+  @brief Flag for BinBlockWriter to store a CRC32C of every block, checked on read.
+*/
+const uint32_t bin_block_crc = 1;
+
+/**
+  @brief Flag for BinBlockWriter to store blocks without compressing them.
+*/
+const uint32_t bin_block_uncompressed = 2;
+
+const uint32_t __bin_block_stored = 0x80000000u;
+
+/**
+  @brief Writer compressing its data in blocks into another writer.
+  @param Out Type of the writer the blocks are written to.
+*/
+template<class Out>
+class BinBlockWriter: public BinWriter<BinBlockWriter<Out>>
+{
+  friend class BinWriter<BinBlockWriter<Out>>;
+
+  struct __Entry
+  {
+    uint64_t offset;
+    uint32_t size;
+    uint32_t crc;
+  };
+
+  Out& _out;
+  uint64_t _offset = 0;
+  uintptr_t _block_size;
+  uint32_t _flags;
+  std::unique_ptr<char[]> _buffer;
+  uintptr_t _capacity;
+  uintptr_t _used = 0;
+  uint64_t _emitted = 0;
+  std::unique_ptr<uint8_t[]> _scratch;
+  std::vector<__Entry> _index;
+  bool _finished = false;
+
+  //compresses a block and writes it out
+  void _emit(const char* data, uintptr_t len)
+  {
+    size_t size = len;
+    if(!(_flags & bin_block_uncompressed))
+      size = bin_lz_compress((const uint8_t*)data, len, _scratch.get());
+    __Entry entry;
+    entry.offset = _offset;
+    entry.crc = 0;
+    if(size >= len)
+    {
+      entry.size = uint32_t(len) | __bin_block_stored;
+      size = len;
+    }
+    else
+    {
+      entry.size = uint32_t(size);
+      data = (const char*)_scratch.get();
+    }
+    if(_flags & bin_block_crc)
+      entry.crc = bin_crc32c(data, size);
+    _out.write_span(data, size);
+    _index.push_back(entry);
+    _offset += size;
+    _emitted += len;
+  }
+
+  //writes out all full blocks in the buffer
+  void _emitFull()
+  {
+    uintptr_t pos = 0;
+    for(; _used - pos >= _block_size; pos += _block_size)
+      _emit(_buffer.get() + pos, _block_size);
+    if(pos != 0)
+    {
+      memmove(_buffer.get(), _buffer.get() + pos, _used - pos);
+      _used -= pos;
+    }
+  }
+
+  char* _prepare(uintptr_t len)
+  {
+    if(_capacity - _used < len)
+    {
+      _emitFull();
+      if(_capacity - _used < len)
+      {
+        uintptr_t new_cap = _used + len;
+        std::unique_ptr<char[]> buffer(new char[new_cap]);
+        memcpy(buffer.get(), _buffer.get(), _used);
+        _buffer = std::move(buffer);
+        _capacity = new_cap;
+      }
+    }
+    return _buffer.get() + _used;
+  }
+
+  void _advance(uintptr_t len)
+  {
+    _used += len;
+    if(_used >= _block_size)
+      _emitFull();
+  }
+
+  void _writeBytes(const void* data, uintptr_t len)
+  {
+    const char* src = (const char*)data;
+    while(len > 0)
+    {
+      if(_used == 0 && len >= _block_size)
+      {
+        //whole blocks are compressed straight from the caller's memory
+        _emit(src, _block_size);
+        src += _block_size;
+        len -= _block_size;
+        continue;
+      }
+      uintptr_t n = _block_size - _used < len? _block_size - _used : len;
+      memcpy(_buffer.get() + _used, src, n);
+      _advance(n);
+      src += n;
+      len -= n;
+    }
+  }
+
+public:
+  /**
+    @brief Constructor
+    @param out The writer to write the compressed blocks to. It must outlive this
+    object.
+    @param block_size Size in bytes of the uncompressed blocks. default: 64 KiB
+    @param flags bin_block_crc and bin_block_uncompressed or'd together. default: 0
+  */
+  BinBlockWriter(Out& out, uintptr_t block_size = uintptr_t(64) << 10,
+    uint32_t flags = 0):
+    _out(out),
+    _block_size(block_size < 256? 256 : block_size),
+    _flags(flags & (bin_block_crc | bin_block_uncompressed))
+  {
+    if(_block_size > 0x7fffffff)
+      _block_size = 0x7fffffff;
+    _capacity = _block_size * 2;
+    _buffer.reset(new char[_capacity]);
+    _scratch.reset(new uint8_t[bin_lz_max_size(_block_size)]);
+  }
+  BinBlockWriter(const BinBlockWriter&) = delete;
+  void operator=(const BinBlockWriter&) = delete;
+  ~BinBlockWriter()
+  {
+    finish();
+  }
+
+  /**
+    @brief Returns the number of uncompressed bytes written.
+  */
+  uint64_t tell() const
+  {
+    return _emitted + _used;
+  }
+  uint64_t size() const
+  {
+    return tell();
+  }
+
+  /**
+    @brief Returns the number of compressed bytes written to the output so far.
+  */
+  uint64_t compressed_size() const
+  {
+    return _offset;
+  }
+
+  /**
+    @brief Writes the remaining data, the block index and the footer. Nothing can be
+    written afterwards.
+  */
+  void finish()
+  {
+    if(_finished)
+      return;
+    _emitFull();
+    if(_used != 0)
+      _emit(_buffer.get(), _used);
+    _used = 0;
+    _finished = true;
+
+    uint64_t index_offset = _offset;
+    for(const __Entry& entry: _index)
+    {
+      _out.write(entry.offset);
+      _out.write(entry.size);
+      if(_flags & bin_block_crc)
+        _out.write(entry.crc);
+    }
+    _out.write(index_offset);
+    _out.write(uint64_t(_emitted));
+    _out.write(uint32_t(_block_size));
+    _out.write(uint32_t(_index.size()));
+    _out.write(_flags);
+    _out.write(bin_block_magic);
+  }
+};
+
+/**
+  @brief Reader for data written by BinBlockWriter.
+
+  Blocks are decompressed one at a time as they are read. good() is false if the
+  footer or index is malformed, or a block fails to decompress or, if the data has
+  checksums, to match its checksum.
+*/
+class BinBlockReader: public BinReader<BinBlockReader>
+{
+  friend class BinReader<BinBlockReader>;
+
+  const char* _data = nullptr;
+  const char* _index = nullptr;
+  uint64_t _index_offset = 0;
+  uint64_t _raw_size = 0;
+  uintptr_t _block_size = 0;
+  uint32_t _blocks = 0;
+  uint32_t _flags = 0;
+  uintptr_t _entry_size = 12;
+
+  std::unique_ptr<char[]> _buffer;
+  uintptr_t _capacity = 0;
+  uintptr_t _begin = 0;
+  uintptr_t _end = 0;
+  uint32_t _next_block = 0;
+  uint64_t _pos = 0;
+
+  uintptr_t _rawSize(uint32_t block) const
+  {
+    uint64_t start = uint64_t(block) * _block_size;
+    uint64_t left = _raw_size - start;
+    return left < _block_size? uintptr_t(left) : _block_size;
+  }
+
+  //decompresses a block into dest, which must have room for its uncompressed size
+  bool _decompress(uint32_t block, char* dest)
+  {
+    uint64_t offset;
+    uint32_t size;
+    const char* entry = _index + uintptr_t(block) * _entry_size;
+    memcpy(&offset, entry, 8);
+    memcpy(&size, entry + 8, 4);
+    bool stored = (size & __bin_block_stored) != 0;
+    size &= ~__bin_block_stored;
+    uintptr_t raw = _rawSize(block);
+    bool ok;
+    if(offset > _index_offset || size > _index_offset - offset)
+      ok = false;
+    else if((_flags & bin_block_crc) && !_checkCrc(entry, offset, size))
+      ok = false;
+    else if(stored)
+    {
+      ok = size == raw;
+      if(ok)
+        memcpy(dest, _data + offset, raw);
+    }
+    else ok = bin_lz_decompress((const uint8_t*)_data + offset, size, (uint8_t*)dest, raw);
+    if(!ok)
+      _good = false;
+    return ok;
+  }
+
+  bool _checkCrc(const char* entry, uint64_t offset, uint32_t size) const
+  {
+    uint32_t crc;
+    memcpy(&crc, entry + 12, 4);
+    return bin_crc32c(_data + offset, size) == crc;
+  }
+
+  uintptr_t _fill(uintptr_t len)
+  {
+    while(_end - _begin < len && _next_block < _blocks && _good)
+    {
+      uintptr_t left = _end - _begin;
+      uintptr_t raw = _rawSize(_next_block);
+      if(left + raw > _capacity)
+      {
+        uintptr_t new_cap = _capacity * 2 > left + raw? _capacity * 2 : left + raw;
+        std::unique_ptr<char[]> buffer(new char[new_cap]);
+        memcpy(buffer.get(), _buffer.get() + _begin, left);
+        _buffer = std::move(buffer);
+        _capacity = new_cap;
+      }
+      else memmove(_buffer.get(), _buffer.get() + _begin, left);
+      _begin = 0;
+      _end = left;
+      if(!_decompress(_next_block, _buffer.get() + _end))
+        break;
+      _end += raw;
+      ++_next_block;
+    }
+    return _end - _begin;
+  }
+  const char* _cursor() const
+  {
+    return _buffer.get() + _begin;
+  }
+  void _consume(uintptr_t len)
+  {
+    _begin += len;
+    _pos += len;
+  }
+  bool _mayContain(uintptr_t len)
+  {
+    return len <= _raw_size - _pos;
+  }
+
+public:
+  using BinReader<BinBlockReader>::read;
+
+  /**
+    @brief Constructor. Reads from memory which must outlive the object.
+    @param data Pointer to the start of the first block.
+    @param size Size in bytes of the data, up to and including the footer.
+  */
+  BinBlockReader(const char* data, uintptr_t size)
+  {
+    uint64_t index_offset, raw_size;
+    uint32_t block_size, blocks, flags, magic;
+    if(size < bin_block_footer_size)
+    {
+      _good = false;
+      return;
+    }
+    const char* footer = data + size - bin_block_footer_size;
+    memcpy(&index_offset, footer, 8);
+    memcpy(&raw_size, footer + 8, 8);
+    memcpy(&block_size, footer + 16, 4);
+    memcpy(&blocks, footer + 20, 4);
+    memcpy(&flags, footer + 24, 4);
+    memcpy(&magic, footer + 28, 4);
+    uintptr_t entry_size = flags & bin_block_crc? 16 : 12;
+    uint64_t body = size - bin_block_footer_size;
+    if(magic != bin_block_magic || block_size == 0 || index_offset > body
+      || (flags & ~(bin_block_crc | bin_block_uncompressed)) != 0
+      || (body - index_offset) / entry_size < blocks
+      || raw_size > uint64_t(blocks) * block_size
+      || (blocks != 0 && raw_size <= uint64_t(blocks - 1) * block_size))
+    {
+      _good = false;
+      return;
+    }
+    _data = data;
+    _index = data + index_offset;
+    _index_offset = index_offset;
+    _raw_size = raw_size;
+    _block_size = block_size;
+    _blocks = blocks;
+    _flags = flags;
+    _entry_size = entry_size;
+    _capacity = _block_size * 2;
+    _buffer.reset(new char[_capacity]);
+  }
+  BinBlockReader(const BinBlockReader&) = delete;
+  void operator=(const BinBlockReader&) = delete;
+
+  /**
+    @brief Returns the size of the uncompressed data.
+  */
+  uint64_t size() const
+  {
+    return _raw_size;
+  }
+
+  /**
+    @brief Returns the number of uncompressed bytes left to read.
+  */
+  uint64_t remaining() const
+  {
+    return _raw_size - _pos;
+  }
+
+  /**
+    @brief Returns the position indicator in bytes from the beginning of the
+    uncompressed data.
+  */
+  uint64_t tell() const
+  {
+    return _pos;
+  }
+
+  /**
+    @brief Returns the number of blocks.
+  */
+  uint32_t blocks() const
+  {
+    return _blocks;
+  }
+
+  /**
+    @brief Returns true if the blocks have checksums that are checked as they are
+    read.
+  */
+  bool checksummed() const
+  {
+    return (_flags & bin_block_crc) != 0;
+  }
+
+  /**
+    @brief Returns the uncompressed size of the blocks.
+  */
+  uintptr_t block_size() const
+  {
+    return _block_size;
+  }
+
+  /**
+    @brief Moves the position indicator to a position in the uncompressed data,
+    decompressing only the block it is in.
+    @param pos The position. Positions past the end move to the end.
+    @return A reference to the object called.
+  */
+  BinBlockReader& seek(uint64_t pos)
+  {
+    if(pos > _raw_size)
+      pos = _raw_size;
+    _begin = _end = 0;
+    _next_block = uint32_t(pos / _block_size);
+    _pos = uint64_t(_next_block) * _block_size;
+    uintptr_t skip = uintptr_t(pos - _pos);
+    if(skip != 0 && _fill(skip) >= skip)
+      _consume(skip);
+    return *this;
+  }
+
+  /**
+    @brief Reads a number of objects, which may span several blocks.
+    @param out Where to copy the objects.
+    @param len Number of objects to read.
+    @return false if the data ends before all objects are read.
+  */
+  template<class T>
+  bool read(T* out, uintptr_t len)
+  {
+    static_assert(std::is_trivially_copyable<T>::value,
+      "BinBlockReader can only read trivially copyable types");
+    if(len > remaining() / sizeof(T))
+    {
+      _good = false;
+      return false;
+    }
+    char* dest = (char*)out;
+    uintptr_t bytes = len * sizeof(T);
+    while(bytes > 0)
+    {
+      if(_begin == _end && _next_block < _blocks && bytes >= _rawSize(_next_block))
+      {
+        //whole blocks are decompressed straight into the destination
+        uintptr_t raw = _rawSize(_next_block);
+        if(!_decompress(_next_block, dest))
+          return false;
+        ++_next_block;
+        _pos += raw;
+        dest += raw;
+        bytes -= raw;
+        continue;
+      }
+      uintptr_t avail = _fill(bytes < _block_size? bytes : _block_size);
+      if(avail == 0)
+      {
+        _good = false;
+        return false;
+      }
+      uintptr_t n = avail < bytes? avail : bytes;
+      memcpy(dest, _cursor(), n);
+      _consume(n);
+      dest += n;
+      bytes -= n;
+    }
+    return true;
+  }
+};
+
+#endif
@@ -0,0 +1,947 @@
+#ifndef BIN_CODEC_H_INCLUDED
+#define BIN_CODEC_H_INCLUDED
+
+/**
+  @file
+  @author Erik Boström <cewbostrom@gmail.com>
+  @date 16.10.2026
+
+  @section LICENSE
+
+  MIT License (MIT)
+
+  Copyright (c) 2015 Erik Boström
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+
+  @section DESCRIPTION
+
+  Compact integer encodings used by BinSerializer and BinDeserializer.
+
+  varint: LEB128, 7 bits per byte with the high bit set on all but the last byte.
+
+  zigzag: maps signed integers to unsigned ones so that values close to zero, positive
+  or negative, get short varints.
+
+  stream vbyte: bulk encoding of 32 bit integers. Each group of four integers has a
+  control byte holding the byte length of each of them, and all control bytes of a
+  chunk are stored ahead of its data bytes. That keeps lengths and data apart so a
+  group can be decoded with a single shuffle. Arrays are split into chunks of
+  bin_svb_chunk integers so that encoders and decoders never need more than
+  bin_svb_max_size(bin_svb_chunk) bytes of contiguous buffer. The shuffles use SSSE3
+  when it is enabled at compile time, otherwise a scalar loop.
+
+  frame of reference: blocks of bin_for_block integers from a sorted array. Each
+  integer is replaced by its distance to the integer four places before it, which
+  keeps four independent running sums that map onto the four lanes of a SIMD
+  register. The smallest distance in the block is stored as a varint and subtracted
+  from the others, which are then bit-packed with the smallest width that holds them,
+  interleaved over four 32 bit lanes. Unsorted input is still encoded losslessly, it
+  just does not compress. Packing and unpacking use SSE2 when available.
+
+  lz: byte oriented LZ77 compression in the style of LZ4. The input is a series of
+  sequences, each a token byte holding a literal length and a match length in its two
+  nibbles, followed by the literals, a two byte little endian offset back into the
+  output and the match. Lengths that do not fit in a nibble continue in extra bytes of
+  255 and a final byte below it. The last sequence has only literals. Matches are
+  found through a hash table of four byte prefixes, and the decoder checks every
+  length and offset against its buffers so corrupt input can not make it read or
+  write out of bounds.
+
+  crc32c: the Castagnoli CRC, for detecting corrupt data. Uses the SSE4.2 crc32
+  instruction when it is enabled at compile time, otherwise slicing-by-8 tables.
+
+  byte order: arrays of 2, 4 and 8 byte integers are byte swapped with SSSE3 or AVX2
+  byte shuffles when enabled at compile time, 16 or 32 bytes at a time.
+*/
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/**
+  @brief True if the host stores integers most significant byte first.
+*/
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) \
+  && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+const bool bin_big_endian_host = true;
+#else
+const bool bin_big_endian_host = false;
+#endif
+
+/**
+  @brief Maximum number of bytes in a varint encoded 64 bit integer.
+*/
+const size_t bin_varint_max_size = 10;
+
+/**
+  @brief Number of integers per stream vbyte chunk.
+*/
+const size_t bin_svb_chunk = 1024;
+
+/**
+  @brief Number of integers per frame of reference block.
+*/
+const size_t bin_for_block = 128;
+
+/**
+  @brief Maximum number of bytes a frame of reference block takes.
+*/
+const size_t bin_for_max_size = 1 + bin_varint_max_size + bin_for_block * 8;
+
+inline uint64_t bin_zigzag_encode(int64_t v)
+{
+  return (uint64_t(v) << 1) ^ uint64_t(v >> 63);
+}
+
+inline int64_t bin_zigzag_decode(uint64_t v)
+{
+  return int64_t(v >> 1) ^ -int64_t(v & 1);
+}
+
+/**
+  @brief Encodes an integer as a varint.
+  @param v The integer.
+  @param out Output buffer. Must have room for bin_varint_max_size bytes.
+  @return Number of bytes written.
+*/
+inline size_t bin_varint_encode(uint64_t v, uint8_t* out)
+{
+  size_t len = 0;
+  while(v >= 0x80)
+  {
+    out[len++] = uint8_t(v) | 0x80;
+    v >>= 7;
+  }
+  out[len++] = uint8_t(v);
+  return len;
+}
+
+/**
+  @brief Decodes a varint.
+  @param in Input buffer.
+  @param avail Number of bytes available in the input buffer.
+  @param v Receives the integer.
+  @return Number of bytes read, 0 if the input is truncated or malformed.
+*/
+inline size_t bin_varint_decode(const uint8_t* in, size_t avail, uint64_t& v)
+{
+  uint64_t ret = 0;
+  size_t max = avail < bin_varint_max_size? avail : bin_varint_max_size;
+  for(size_t i = 0; i < max; ++i)
+  {
+    ret |= uint64_t(in[i] & 0x7f) << (7 * i);
+    if((in[i] & 0x80) == 0)
+    {
+      v = ret;
+      return i + 1;
+    }
+  }
+  return 0;
+}
+
+/**
+  @brief Maximum number of bytes n integers take when stream vbyte encoded.
+*/
+inline size_t bin_svb_max_size(size_t n)
+{
+  return ((n + 3) >> 2) + (n << 2);
+}
+
+struct __BinSvbTables
+{
+  uint8_t length[256];
+  uint8_t decode[256][16];
+  uint8_t encode[256][16];
+
+  __BinSvbTables()
+  {
+    for(int c = 0; c < 256; ++c)
+    {
+      int pos = 0;
+      memset(decode[c], 0x80, 16);
+      memset(encode[c], 0x80, 16);
+      for(int lane = 0; lane < 4; ++lane)
+      {
+        int bytes = ((c >> (lane * 2)) & 3) + 1;
+        for(int b = 0; b < bytes; ++b)
+        {
+          decode[c][lane * 4 + b] = uint8_t(pos);
+          encode[c][pos] = uint8_t(lane * 4 + b);
+          ++pos;
+        }
+      }
+      length[c] = uint8_t(pos);
+    }
+  }
+
+  static const __BinSvbTables& get()
+  {
+    static const __BinSvbTables tables;
+    return tables;
+  }
+};
+
+inline unsigned __bin_svb_code(uint32_t v)
+{
+  return (v > 0xff) + (v > 0xffff) + (v > 0xffffff);
+}
+
+//encodes at most bin_svb_chunk integers
+inline size_t __bin_svb_encode_chunk(const uint32_t* in, size_t n, uint8_t* out)
+{
+  uint8_t* control = out;
+  uint8_t* data = out + ((n + 3) >> 2);
+  size_t i = 0;
+
+#if defined(__SSSE3__)
+  const __BinSvbTables& tables = __BinSvbTables::get();
+  for(; i + 4 <= n; i += 4)
+  {
+    unsigned c = __bin_svb_code(in[i]) | __bin_svb_code(in[i + 1]) << 2
+      | __bin_svb_code(in[i + 2]) << 4 | __bin_svb_code(in[i + 3]) << 6;
+    __m128i v = _mm_loadu_si128((const __m128i*)(in + i));
+    v = _mm_shuffle_epi8(v, _mm_loadu_si128((const __m128i*)tables.encode[c]));
+    _mm_storeu_si128((__m128i*)data, v);
+    *control++ = uint8_t(c);
+    data += tables.length[c];
+  }
+#endif
+
+  for(; i < n; i += 4)
+  {
+    unsigned c = 0;
+    for(size_t lane = 0; lane < 4 && i + lane < n; ++lane)
+    {
+      uint32_t v = in[i + lane];
+      unsigned code = __bin_svb_code(v);
+      c |= code << (lane * 2);
+      for(unsigned b = 0; b <= code; ++b)
+        *data++ = uint8_t(v >> (8 * b));
+    }
+    *control++ = uint8_t(c);
+  }
+  return data - out;
+}
+
+//decodes at most bin_svb_chunk integers, returns 0 if the input is truncated
+inline size_t __bin_svb_decode_chunk(const uint8_t* in, size_t avail, uint32_t* out,
+  size_t n)
+{
+  const __BinSvbTables& tables = __BinSvbTables::get();
+  size_t groups = (n + 3) >> 2;
+  if(avail < groups)
+    return 0;
+  const uint8_t* control = in;
+  const uint8_t* data = in + groups;
+  const uint8_t* end = in + avail;
+
+  //the last group may be partial, so its unused lanes must be zero length codes
+  size_t data_len = 0;
+  for(size_t g = 0; g < groups; ++g)
+    data_len += tables.length[control[g]];
+  if(n & 3)
+    data_len -= 4 - (n & 3);
+  if(data_len > size_t(end - data))
+    return 0;
+
+  size_t i = 0;
+#if defined(__SSSE3__)
+  for(; i + 4 <= n && end - data >= 16; i += 4)
+  {
+    uint8_t c = *control++;
+    __m128i v = _mm_loadu_si128((const __m128i*)data);
+    v = _mm_shuffle_epi8(v, _mm_loadu_si128((const __m128i*)tables.decode[c]));
+    _mm_storeu_si128((__m128i*)(out + i), v);
+    data += tables.length[c];
+  }
+#endif
+
+  for(; i < n; i += 4)
+  {
+    uint8_t c = *control++;
+    for(size_t lane = 0; lane < 4 && i + lane < n; ++lane)
+    {
+      unsigned bytes = ((c >> (lane * 2)) & 3) + 1;
+      uint32_t v = 0;
+      for(unsigned b = 0; b < bytes; ++b)
+        v |= uint32_t(*data++) << (8 * b);
+      out[i + lane] = v;
+    }
+  }
+  return data - in;
+}
+
+/**
+  @brief Stream vbyte encodes an array of integers.
+  @param in The integers.
+  @param n Number of integers.
+  @param out Output buffer. Must have room for bin_svb_max_size(n) bytes.
+  @return Number of bytes written.
+*/
+inline size_t bin_svb_encode(const uint32_t* in, size_t n, uint8_t* out)
+{
+  size_t len = 0;
+  for(size_t i = 0; i < n; i += bin_svb_chunk)
+  {
+    size_t m = n - i < bin_svb_chunk? n - i : bin_svb_chunk;
+    len += __bin_svb_encode_chunk(in + i, m, out + len);
+  }
+  return len;
+}
+
+/**
+  @brief Decodes an array of stream vbyte encoded integers.
+  @param in Input buffer.
+  @param avail Number of bytes available in the input buffer.
+  @param out Receives the integers.
+  @param n Number of integers to decode.
+  @return Number of bytes read, 0 if the input is truncated or n is 0.
+*/
+inline size_t bin_svb_decode(const uint8_t* in, size_t avail, uint32_t* out, size_t n)
+{
+  size_t len = 0;
+  for(size_t i = 0; i < n; i += bin_svb_chunk)
+  {
+    size_t m = n - i < bin_svb_chunk? n - i : bin_svb_chunk;
+    size_t used = __bin_svb_decode_chunk(in + len, avail - len, out + i, m);
+    if(used == 0)
+      return 0;
+    len += used;
+  }
+  return len;
+}
+
+inline unsigned __bin_bit_width(uint32_t v)
+{
+  unsigned b = 0;
+  while(v != 0)
+  {
+    ++b;
+    v >>= 1;
+  }
+  return b;
+}
+
+//packs 128 integers of at most b bits into b * 16 bytes. integer 4 * i + lane goes
+//into 32 bit lane lane of the i:th b bit slot
+inline void __bin_pack128(const uint32_t* in, unsigned b, uint8_t* out)
+{
+  if(b == 0)
+    return;
+#if defined(__SSE2__)
+  __m128i acc = _mm_setzero_si128();
+  unsigned shift = 0;
+  for(unsigned i = 0; i < 32; ++i)
+  {
+    __m128i v = _mm_loadu_si128((const __m128i*)(in + 4 * i));
+    acc = _mm_or_si128(acc, _mm_sll_epi32(v, _mm_cvtsi32_si128(shift)));
+    if(shift + b >= 32)
+    {
+      _mm_storeu_si128((__m128i*)out, acc);
+      out += 16;
+      acc = shift + b > 32?
+        _mm_srl_epi32(v, _mm_cvtsi32_si128(32 - shift)) : _mm_setzero_si128();
+    }
+    shift = (shift + b) & 31;
+  }
+#else
+  for(unsigned lane = 0; lane < 4; ++lane)
+  {
+    uint64_t acc = 0;
+    unsigned bits = 0;
+    uint8_t* dest = out + lane * 4;
+    for(unsigned i = 0; i < 32; ++i)
+    {
+      acc |= uint64_t(in[4 * i + lane]) << bits;
+      bits += b;
+      if(bits >= 32)
+      {
+        uint32_t word = uint32_t(acc);
+        memcpy(dest, &word, 4);
+        dest += 16;
+        acc >>= 32;
+        bits -= 32;
+      }
+    }
+  }
+#endif
+}
+
+//unpacks 128 integers packed by __bin_pack128
+inline void __bin_unpack128(const uint8_t* in, unsigned b, uint32_t* out)
+{
+  if(b == 0)
+  {
+    memset(out, 0, 128 * sizeof(uint32_t));
+    return;
+  }
+#if defined(__SSE2__)
+  __m128i mask = _mm_set1_epi32(b == 32? -1 : (int)((1u << b) - 1));
+  __m128i word = _mm_loadu_si128((const __m128i*)in);
+  unsigned shift = 0;
+  for(unsigned i = 0; i < 32; ++i)
+  {
+    __m128i v = _mm_srl_epi32(word, _mm_cvtsi32_si128(shift));
+    if(shift + b >= 32 && i != 31)
+    {
+      in += 16;
+      word = _mm_loadu_si128((const __m128i*)in);
+      if(shift + b > 32)
+        v = _mm_or_si128(v, _mm_sll_epi32(word, _mm_cvtsi32_si128(32 - shift)));
+    }
+    _mm_storeu_si128((__m128i*)(out + 4 * i), _mm_and_si128(v, mask));
+    shift = (shift + b) & 31;
+  }
+#else
+  uint32_t mask = b == 32? ~0u : (1u << b) - 1;
+  for(unsigned lane = 0; lane < 4; ++lane)
+  {
+    const uint8_t* src = in + lane * 4;
+    uint64_t acc = 0;
+    unsigned bits = 0;
+    for(unsigned i = 0; i < 32; ++i)
+    {
+      if(bits < b)
+      {
+        uint32_t word;
+        memcpy(&word, src, 4);
+        src += 16;
+        acc |= uint64_t(word) << bits;
+        bits += 32;
+      }
+      out[4 * i + lane] = uint32_t(acc) & mask;
+      acc >>= b;
+      bits -= b;
+    }
+  }
+#endif
+}
+
+/**
+  @brief Frame of reference encodes a block of bin_for_block integers.
+  @param in The integers.
+  @param prev The last four integers before the block, zero for the first block.
+  Receives the last four integers of the block.
+  @param out Output buffer. Must have room for bin_for_max_size bytes.
+  @return Number of bytes written.
+*/
+inline size_t bin_for_encode32(const uint32_t* in, uint32_t* prev, uint8_t* out)
+{
+  uint32_t delta[bin_for_block];
+  uint32_t min = ~0u;
+  for(size_t i = 0; i < bin_for_block; ++i)
+  {
+    delta[i] = in[i] - (i < 4? prev[i] : in[i - 4]);
+    if(delta[i] < min) min = delta[i];
+  }
+  uint32_t bits = 0;
+  for(size_t i = 0; i < bin_for_block; ++i)
+  {
+    delta[i] -= min;
+    bits |= delta[i];
+  }
+  unsigned b = __bin_bit_width(bits);
+
+  size_t len = 0;
+  out[len++] = uint8_t(b);
+  len += bin_varint_encode(min, out + len);
+  __bin_pack128(delta, b, out + len);
+  memcpy(prev, in + bin_for_block - 4, 4 * sizeof(uint32_t));
+  return len + b * 16;
+}
+
+/**
+  @brief Decodes a block written by bin_for_encode32.
+  @param in Input buffer.
+  @param avail Number of bytes available in the input buffer.
+  @param prev The last four integers before the block. Receives the last four integers
+  of the block.
+  @param out Receives bin_for_block integers.
+  @return Number of bytes read, 0 if the input is truncated or malformed.
+*/
+inline size_t bin_for_decode32(const uint8_t* in, size_t avail, uint32_t* prev,
+  uint32_t* out)
+{
+  if(avail < 2 || in[0] > 32)
+    return 0;
+  unsigned b = in[0];
+  uint64_t base;
+  size_t len = bin_varint_decode(in + 1, avail - 1, base);
+  if(len == 0 || 1 + len + b * 16 > avail)
+    return 0;
+  __bin_unpack128(in + 1 + len, b, out);
+
+  //undo the distances, four running sums at a time
+#if defined(__SSE2__)
+  __m128i sum = _mm_loadu_si128((const __m128i*)prev);
+  __m128i basev = _mm_set1_epi32((int)uint32_t(base));
+  for(size_t i = 0; i < bin_for_block; i += 4)
+  {
+    __m128i v = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(out + i)), basev);
+    sum = _mm_add_epi32(sum, v);
+    _mm_storeu_si128((__m128i*)(out + i), sum);
+  }
+  _mm_storeu_si128((__m128i*)prev, sum);
+#else
+  for(size_t i = 0; i < bin_for_block; ++i)
+  {
+    prev[i & 3] += out[i] + uint32_t(base);
+    out[i] = prev[i & 3];
+  }
+#endif
+  return 1 + len + b * 16;
+}
+
+/**
+  @brief Frame of reference encodes a block of bin_for_block 64 bit integers.
+
+  Blocks whose distances span more than 32 bits are stored raw.
+
+  @see bin_for_encode32
+*/
+inline size_t bin_for_encode64(const uint64_t* in, uint64_t* prev, uint8_t* out)
+{
+  uint64_t delta[bin_for_block];
+  uint64_t min = ~uint64_t(0);
+  uint64_t max = 0;
+  for(size_t i = 0; i < bin_for_block; ++i)
+  {
+    delta[i] = in[i] - (i < 4? prev[i] : in[i - 4]);
+    if(delta[i] < min) min = delta[i];
+    if(delta[i] > max) max = delta[i];
+  }
+
+  size_t len = 0;
+  if(max - min > 0xffffffffu)
+  {
+    out[len++] = 64;
+    memcpy(out + len, in, bin_for_block * sizeof(uint64_t));
+    len += bin_for_block * sizeof(uint64_t);
+  }
+  else
+  {
+    uint32_t packed[bin_for_block];
+    uint32_t bits = 0;
+    for(size_t i = 0; i < bin_for_block; ++i)
+    {
+      packed[i] = uint32_t(delta[i] - min);
+      bits |= packed[i];
+    }
+    unsigned b = __bin_bit_width(bits);
+    out[len++] = uint8_t(b);
+    len += bin_varint_encode(min, out + len);
+    __bin_pack128(packed, b, out + len);
+    len += b * 16;
+  }
+  memcpy(prev, in + bin_for_block - 4, 4 * sizeof(uint64_t));
+  return len;
+}
+
+/**
+  @brief Decodes a block written by bin_for_encode64.
+  @see bin_for_decode32
+*/
+inline size_t bin_for_decode64(const uint8_t* in, size_t avail, uint64_t* prev,
+  uint64_t* out)
+{
+  if(avail < 1)
+    return 0;
+  unsigned b = in[0];
+  if(b == 64)
+  {
+    if(avail < 1 + bin_for_block * sizeof(uint64_t))
+      return 0;
+    memcpy(out, in + 1, bin_for_block * sizeof(uint64_t));
+    memcpy(prev, out + bin_for_block - 4, 4 * sizeof(uint64_t));
+    return 1 + bin_for_block * sizeof(uint64_t);
+  }
+  if(b > 32)
+    return 0;
+  uint64_t base;
+  size_t len = bin_varint_decode(in + 1, avail - 1, base);
+  if(len == 0 || 1 + len + b * 16 > avail)
+    return 0;
+
+  uint32_t packed[bin_for_block];
+  __bin_unpack128(in + 1 + len, b, packed);
+  for(size_t i = 0; i < bin_for_block; ++i)
+  {
+    prev[i & 3] += packed[i] + base;
+    out[i] = prev[i & 3];
+  }
+  return 1 + len + b * 16;
+}
+
+/**
+  @brief Maximum number of bytes bin_lz_compress produces for n bytes of input.
+*/
+inline size_t bin_lz_max_size(size_t n)
+{
+  return n + n / 255 + 16;
+}
+
+inline uint32_t __bin_load32(const uint8_t* p)
+{
+  uint32_t v;
+  memcpy(&v, p, 4);
+  return v;
+}
+
+inline uint64_t __bin_load64(const uint8_t* p)
+{
+  uint64_t v;
+  memcpy(&v, p, 8);
+  return v;
+}
+
+inline unsigned __bin_ctz64(uint64_t v)
+{
+#if defined(__GNUC__)
+  return unsigned(__builtin_ctzll(v));
+#else
+  unsigned n = 0;
+  for(; (v & 1) == 0; v >>= 1)
+    ++n;
+  return n;
+#endif
+}
+
+inline uint8_t* __bin_lz_length(uint8_t* out, size_t len)
+{
+  for(; len >= 255; len -= 255)
+    *out++ = 255;
+  *out++ = uint8_t(len);
+  return out;
+}
+
+inline uint8_t* __bin_lz_sequence(uint8_t* out, const uint8_t* literals, size_t lit_len,
+  size_t offset, size_t match_len)
+{
+  uint8_t* token = out++;
+  *token = uint8_t((lit_len < 15? lit_len : 15) << 4);
+  if(lit_len >= 15)
+    out = __bin_lz_length(out, lit_len - 15);
+  if(lit_len)
+    memcpy(out, literals, lit_len);
+  out += lit_len;
+  if(match_len == 0)
+    return out;
+  *out++ = uint8_t(offset);
+  *out++ = uint8_t(offset >> 8);
+  match_len -= 4;
+  *token |= uint8_t(match_len < 15? match_len : 15);
+  if(match_len >= 15)
+    out = __bin_lz_length(out, match_len - 15);
+  return out;
+}
+
+/**
+  @brief Compresses n bytes.
+  @param in The data.
+  @param n Number of bytes. Must be less than 4 GiB.
+  @param out Where to write the compressed data. Must have room for bin_lz_max_size(n)
+  bytes.
+  @return Number of bytes written.
+*/
+inline size_t bin_lz_compress(const uint8_t* in, size_t n, uint8_t* out)
+{
+  const unsigned hash_bits = 12;
+  uint32_t table[1u << hash_bits];
+  memset(table, 0, sizeof(table));
+
+  uint8_t* op = out;
+  size_t anchor = 0;
+  size_t ip = 0;
+  //matches stay clear of the last bytes, which always end up as literals
+  const size_t limit = n > 12? n - 12 : 0;
+  const size_t match_end = n > 5? n - 5 : 0;
+  while(ip < limit)
+  {
+    uint32_t seq = __bin_load32(in + ip);
+    uint32_t h = (seq * 2654435761u) >> (32 - hash_bits);
+    size_t ref = table[h];
+    table[h] = uint32_t(ip);
+    if(ref >= ip || ip - ref > 65535 || __bin_load32(in + ref) != seq)
+    {
+      ip += 1 + ((ip - anchor) >> 6);
+      continue;
+    }
+
+    while(ip > anchor && ref > 0 && in[ip - 1] == in[ref - 1])
+    {
+      --ip;
+      --ref;
+    }
+    size_t len = 4;
+    for(;;)
+    {
+      if(ip + len + 8 > match_end)
+      {
+        while(ip + len < match_end && in[ip + len] == in[ref + len])
+          ++len;
+        break;
+      }
+      uint64_t diff = __bin_load64(in + ip + len) ^ __bin_load64(in + ref + len);
+      if(diff != 0)
+      {
+        len += __bin_ctz64(diff) >> 3;
+        break;
+      }
+      len += 8;
+    }
+    op = __bin_lz_sequence(op, in + anchor, ip - anchor, ip - ref, len);
+    ip += len;
+    anchor = ip;
+    if(ip - 2 < limit)
+      table[(__bin_load32(in + ip - 2) * 2654435761u) >> (32 - hash_bits)] = uint32_t(ip - 2);
+  }
+  op = __bin_lz_sequence(op, in + anchor, n - anchor, 0, 0);
+  return size_t(op - out);
+}
+
+inline bool __bin_lz_read_length(const uint8_t*& ip, const uint8_t* end, size_t& len)
+{
+  uint8_t b;
+  do
+  {
+    if(ip == end)
+      return false;
+    b = *ip++;
+    len += b;
+  }while(b == 255);
+  return true;
+}
+
+/**
+  @brief Decompresses data written by bin_lz_compress.
+  @param in The compressed data.
+  @param n Number of bytes of compressed data.
+  @param out Where to write the data.
+  @param len Size of the data when decompressed.
+  @return false if the compressed data is malformed or does not decompress to exactly
+  len bytes.
+*/
+inline bool bin_lz_decompress(const uint8_t* in, size_t n, uint8_t* out, size_t len)
+{
+  const uint8_t* ip = in;
+  const uint8_t* end = in + n;
+  uint8_t* op = out;
+  uint8_t* op_end = out + len;
+  while(ip < end)
+  {
+    unsigned token = *ip++;
+    size_t lit_len = token >> 4;
+    if(lit_len == 15 && !__bin_lz_read_length(ip, end, lit_len))
+      return false;
+    if(lit_len > size_t(end - ip) || lit_len > size_t(op_end - op))
+      return false;
+    if(lit_len)
+      memcpy(op, ip, lit_len);
+    ip += lit_len;
+    op += lit_len;
+    if(ip == end)
+      break;
+
+    if(end - ip < 2)
+      return false;
+    size_t offset = size_t(ip[0]) | (size_t(ip[1]) << 8);
+    ip += 2;
+    size_t match_len = token & 15;
+    if(match_len == 15 && !__bin_lz_read_length(ip, end, match_len))
+      return false;
+    match_len += 4;
+    if(offset == 0 || offset > size_t(op - out) || match_len > size_t(op_end - op))
+      return false;
+
+    const uint8_t* match = op - offset;
+    if(offset >= 8 && match_len + 8 <= size_t(op_end - op))
+    {
+      //copies eight bytes at a time, possibly past the match into room left free
+      for(size_t i = 0; i < match_len; i += 8)
+        memcpy(op + i, match + i, 8);
+    }
+    else for(size_t i = 0; i < match_len; ++i)
+      op[i] = match[i];
+    op += match_len;
+  }
+  return op == op_end;
+}
+
+#if !defined(__SSE4_2__)
+struct __BinCrcTables
+{
+  uint32_t t[8][256];
+
+  __BinCrcTables()
+  {
+    for(unsigned i = 0; i < 256; ++i)
+    {
+      uint32_t crc = i;
+      for(int j = 0; j < 8; ++j)
+        crc = (crc >> 1) ^ (0x82f63b78u & (0u - (crc & 1)));
+      t[0][i] = crc;
+    }
+    for(unsigned i = 0; i < 256; ++i)
+      for(int k = 1; k < 8; ++k)
+        t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xff];
+  }
+};
+
+inline const __BinCrcTables& __bin_crc_tables()
+{
+  static const __BinCrcTables tables;
+  return tables;
+}
+#endif
+
+/**
+  @brief Computes the CRC32C of a range of bytes.
+  @param data The bytes.
+  @param len Number of bytes.
+  @param crc CRC of the bytes preceding data, to checksum data in pieces. default: 0
+  @return The CRC of the preceding bytes followed by data.
+*/
+inline uint32_t bin_crc32c(const void* data, size_t len, uint32_t crc = 0)
+{
+  const uint8_t* p = (const uint8_t*)data;
+  crc = ~crc;
+#if defined(__SSE4_2__)
+#if defined(__x86_64__) || defined(_M_X64)
+  uint64_t crc64 = crc;
+  for(; len >= 8; len -= 8, p += 8)
+    crc64 = _mm_crc32_u64(crc64, __bin_load64(p));
+  crc = uint32_t(crc64);
+#endif
+  for(; len >= 4; len -= 4, p += 4)
+    crc = _mm_crc32_u32(crc, __bin_load32(p));
+  for(; len > 0; --len, ++p)
+    crc = _mm_crc32_u8(crc, *p);
+#else
+  const __BinCrcTables& tables = __bin_crc_tables();
+  const uint32_t (*t)[256] = tables.t;
+  for(; len >= 8; len -= 8, p += 8)
+  {
+    crc ^= uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16
+      | uint32_t(p[3]) << 24;
+    crc = t[7][crc & 0xff] ^ t[6][(crc >> 8) & 0xff] ^ t[5][(crc >> 16) & 0xff]
+      ^ t[4][crc >> 24] ^ t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+  }
+  for(; len > 0; --len, ++p)
+    crc = (crc >> 8) ^ t[0][(crc ^ *p) & 0xff];
+#endif
+  return ~crc;
+}
+
+inline uint16_t __bin_bswap(uint16_t v)
+{
+  return uint16_t(v << 8 | v >> 8);
+}
+
+inline uint32_t __bin_bswap(uint32_t v)
+{
+#if defined(__GNUC__)
+  return __builtin_bswap32(v);
+#else
+  return v << 24 | (v & 0xff00) << 8 | (v >> 8 & 0xff00) | v >> 24;
+#endif
+}
+
+inline uint64_t __bin_bswap(uint64_t v)
+{
+#if defined(__GNUC__)
+  return __builtin_bswap64(v);
+#else
+  return uint64_t(__bin_bswap(uint32_t(v))) << 32 | __bin_bswap(uint32_t(v >> 32));
+#endif
+}
+
+template<class U>
+inline void __bin_bswap_scalar(const uint8_t* in, uint8_t* out, size_t n)
+{
+  for(size_t i = 0; i < n; ++i)
+  {
+    U v;
+    memcpy(&v, in + i * sizeof(U), sizeof(U));
+    v = __bin_bswap(v);
+    memcpy(out + i * sizeof(U), &v, sizeof(U));
+  }
+}
+
+/**
+  @brief Reverses the bytes of each of an array of integers.
+  @param in The integers.
+  @param out Where to write the swapped integers. May be the same as in, but must not
+  otherwise overlap it.
+  @param n Number of integers.
+  @param width Size of the integers in bytes: 1, 2, 4 or 8.
+*/
+inline void bin_byteswap(const void* in, void* out, size_t n, size_t width)
+{
+  const uint8_t* ip = (const uint8_t*)in;
+  uint8_t* op = (uint8_t*)out;
+  if(width == 1)
+  {
+    if(ip != op)
+      memmove(op, ip, n);
+    return;
+  }
+  size_t bytes = n * width;
+  size_t i = 0;
+#if defined(__SSSE3__)
+  __m128i mask;
+  if(width == 2)
+    mask = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+  else if(width == 4)
+    mask = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+  else mask = _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+#if defined(__AVX2__)
+  __m256i mask256 = _mm256_broadcastsi128_si256(mask);
+  for(; i + 32 <= bytes; i += 32)
+  {
+    __m256i v = _mm256_loadu_si256((const __m256i*)(ip + i));
+    _mm256_storeu_si256((__m256i*)(op + i), _mm256_shuffle_epi8(v, mask256));
+  }
+#endif
+  for(; i + 16 <= bytes; i += 16)
+  {
+    __m128i v = _mm_loadu_si128((const __m128i*)(ip + i));
+    _mm_storeu_si128((__m128i*)(op + i), _mm_shuffle_epi8(v, mask));
+  }
+#endif
+  if(width == 2)
+    __bin_bswap_scalar<uint16_t>(ip + i, op + i, (bytes - i) / 2);
+  else if(width == 4)
+    __bin_bswap_scalar<uint32_t>(ip + i, op + i, (bytes - i) / 4);
+  else __bin_bswap_scalar<uint64_t>(ip + i, op + i, (bytes - i) / 8);
+}
+
+#endif
@@ -0,0 +1,590 @@
+#ifndef BIN_COLUMN_H_INCLUDED
+#define BIN_COLUMN_H_INCLUDED
+
+/**
+  @file
+  @author Erik Boström <cewbostrom@gmail.com>
+  @date 16.10.2026
+
+  @section LICENSE
+
+  MIT License (MIT)
+
+  Copyright (c) 2015 Erik Boström
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+
+  @section DESCRIPTION
+
+  Columnar serialization of arrays of structs. Each field of the struct is stored as
+  an array of its own, so that readers can load only the fields they need, columns of
+  similar values compress better, and the columns can be processed with SIMD as they
+  are read.
+
+  The structs must declare their fields with BIN_FIELDS, and all fields must be plain.
+  The rows are split into groups of bin_column_group rows, which is the most that is
+  transposed at a time. Structs of two to four fields of 4 bytes, or of two or four
+  fields of 8 bytes, without padding, are transposed with SSE2 shuffles when it is
+  enabled at compile time.
+
+  layout: the number of rows and the number of rows per group as varints, then for
+  each group, aligned to the largest alignment of the fields, each column aligned to
+  the alignment of its field.
+
+  usage:
+
+  struct Particle
+  {
+    float x, y, z, mass;
+
+    BIN_FIELDS(x, y, z, mass)
+  };
+
+  bin_write_columns(serializer, particles.data(), particles.size());
+
+  bin_read_columns(deserializer, particles);
+
+  or, to read only some of the fields in place:
+
+  BinColumns<Particle> columns(deserializer);
+  for(uintptr_t g = 0; g < columns.groups(); ++g)
+  {
+    BinView<float> mass = columns.column<3>(g);
+    ...
+  }
+*/
+
+#include <memory>
+#include <vector>
+#include <type_traits>
+#include <cstring>
+#include <cstdint>
+
+#include "bin_object.h"
+
+/**
+  @brief Default number of rows per group in columnar data.
+*/
+const uintptr_t bin_column_group = 4096;
+
+template<size_t I, class List>
+struct __BinTypeAt;
+
+template<class T, class... Rest>
+struct __BinTypeAt<0, __BinTypeList<T, Rest...>>
+{
+  typedef T type;
+};
+
+template<size_t I, class T, class... Rest>
+struct __BinTypeAt<I, __BinTypeList<T, Rest...>>: __BinTypeAt<I - 1, __BinTypeList<Rest...>>{};
+
+//sizes and alignments of the columns of a list of field types, and the common size
+//of the fields if they all have the same
+template<class List>
+struct __BinColumnShape;
+
+template<>
+struct __BinColumnShape<__BinTypeList<>>
+{
+  static const size_t count = 0;
+  static const size_t align = 1;
+  static const size_t row = 0;
+  static const size_t width = 0;
+  static const bool raw = true;
+
+  static void fill(uintptr_t*, uintptr_t*){}
+};
+
+template<class T, class... Rest>
+struct __BinColumnShape<__BinTypeList<T, Rest...>>
+{
+  typedef __BinColumnShape<__BinTypeList<Rest...>> Next;
+
+  static const size_t count = 1 + Next::count;
+  static const size_t align = alignof(T) > Next::align? alignof(T) : Next::align;
+  static const size_t row = sizeof(T) + Next::row;
+  static const size_t width = Next::count == 0 || Next::width == sizeof(T)? sizeof(T) : 0;
+  static const bool raw = BinCodec<T>::raw && Next::raw;
+
+  static void fill(uintptr_t* sizes, uintptr_t* aligns)
+  {
+    *sizes = sizeof(T);
+    *aligns = alignof(T);
+    Next::fill(sizes + 1, aligns + 1);
+  }
+};
+
+//collects the offsets of the fields of an object
+struct __BinFieldOffsets
+{
+  const char* base;
+  uintptr_t* out;
+
+  void operator()(){}
+  template<class F, class... Rest>
+  void operator()(const F& f, const Rest&... rest)
+  {
+    *out++ = uintptr_t((const char*)&f - base);
+    (*this)(rest...);
+  }
+};
+
+//copies the fields of rows to and from columns, one field at a time
+template<class T, class List, size_t I = 0, size_t K = __BinColumnShape<List>::count>
+struct __BinColumnCopy
+{
+  typedef typename __BinTypeAt<I, List>::type F;
+  typedef __BinColumnCopy<T, List, I + 1, K> Next;
+
+  static void split(const char* rows, uintptr_t m, const uintptr_t* offsets,
+    char* const* cols)
+  {
+    const char* src = rows + offsets[I];
+    char* dest = cols[I];
+    for(uintptr_t i = 0; i < m; ++i)
+      memcpy(dest + i * sizeof(F), src + i * sizeof(T), sizeof(F));
+    Next::split(rows, m, offsets, cols);
+  }
+  static void join(char* rows, uintptr_t m, const uintptr_t* offsets,
+    const char* const* cols)
+  {
+    const char* src = cols[I];
+    char* dest = rows + offsets[I];
+    for(uintptr_t i = 0; i < m; ++i)
+      memcpy(dest + i * sizeof(T), src + i * sizeof(F), sizeof(F));
+    Next::join(rows, m, offsets, cols);
+  }
+};
+
+template<class T, class List, size_t K>
+struct __BinColumnCopy<T, List, K, K>
+{
+  static void split(const char*, uintptr_t, const uintptr_t*, char* const*){}
+  static void join(char*, uintptr_t, const uintptr_t*, const char* const*){}
+};
+
+#if defined(__SSE2__)
+//transposes rows of k fields of w bytes into columns, four rows at a time for 4 byte
+//fields and two for 8 byte fields. returns the number of rows done
+inline uintptr_t __bin_split_dense(const char* rows, uintptr_t m, size_t k, size_t w,
+  char* const* cols)
+{
+  uintptr_t i = 0;
+  if(w == 4 && k == 2)
+    for(; i + 4 <= m; i += 4)
+    {
+      __m128 a = _mm_loadu_ps((const float*)(rows + i * 8));
+      __m128 b = _mm_loadu_ps((const float*)(rows + i * 8 + 16));
+      _mm_storeu_ps((float*)(cols[0] + i * 4), _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+      _mm_storeu_ps((float*)(cols[1] + i * 4), _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+  else if(w == 4 && k == 3)
+    for(; i + 4 <= m; i += 4)
+    {
+      __m128 a = _mm_loadu_ps((const float*)(rows + i * 12));
+      __m128 b = _mm_loadu_ps((const float*)(rows + i * 12 + 16));
+      __m128 c = _mm_loadu_ps((const float*)(rows + i * 12 + 32));
+      __m128 t = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2));
+      __m128 x = _mm_shuffle_ps(a, t, _MM_SHUFFLE(2, 0, 3, 0));
+      t = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1));
+      __m128 u = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3));
+      __m128 y = _mm_shuffle_ps(t, u, _MM_SHUFFLE(2, 0, 2, 0));
+      t = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2));
+      u = _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0));
+      __m128 z = _mm_shuffle_ps(t, u, _MM_SHUFFLE(2, 0, 2, 0));
+      _mm_storeu_ps((float*)(cols[0] + i * 4), x);
+      _mm_storeu_ps((float*)(cols[1] + i * 4), y);
+      _mm_storeu_ps((float*)(cols[2] + i * 4), z);
+    }
+  else if(w == 4 && k == 4)
+    for(; i + 4 <= m; i += 4)
+    {
+      __m128 a = _mm_loadu_ps((const float*)(rows + i * 16));
+      __m128 b = _mm_loadu_ps((const float*)(rows + i * 16 + 16));
+      __m128 c = _mm_loadu_ps((const float*)(rows + i * 16 + 32));
+      __m128 d = _mm_loadu_ps((const float*)(rows + i * 16 + 48));
+      _MM_TRANSPOSE4_PS(a, b, c, d);
+      _mm_storeu_ps((float*)(cols[0] + i * 4), a);
+      _mm_storeu_ps((float*)(cols[1] + i * 4), b);
+      _mm_storeu_ps((float*)(cols[2] + i * 4), c);
+      _mm_storeu_ps((float*)(cols[3] + i * 4), d);
+    }
+  else if(w == 8 && (k == 2 || k == 4))
+    for(; i + 2 <= m; i += 2)
+      for(size_t j = 0; j < k; j += 2)
+      {
+        __m128d a = _mm_loadu_pd((const double*)(rows + i * k * 8 + j * 8));
+        __m128d b = _mm_loadu_pd((const double*)(rows + (i + 1) * k * 8 + j * 8));
+        _mm_storeu_pd((double*)(cols[j] + i * 8), _mm_unpacklo_pd(a, b));
+        _mm_storeu_pd((double*)(cols[j + 1] + i * 8), _mm_unpackhi_pd(a, b));
+      }
+  return i;
+}
+
+//the inverse of __bin_split_dense
+inline uintptr_t __bin_join_dense(char* rows, uintptr_t m, size_t k, size_t w,
+  const char* const* cols)
+{
+  uintptr_t i = 0;
+  if(w == 4 && k == 2)
+    for(; i + 4 <= m; i += 4)
+    {
+      __m128 x = _mm_loadu_ps((const float*)(cols[0] + i * 4));
+      __m128 y = _mm_loadu_ps((const float*)(cols[1] + i * 4));
+      _mm_storeu_ps((float*)(rows + i * 8), _mm_unpacklo_ps(x, y));
+      _mm_storeu_ps((float*)(rows + i * 8 + 16), _mm_unpackhi_ps(x, y));
+    }
+  else if(w == 4 && k == 3)
+    for(; i + 4 <= m; i += 4)
+    {
+      __m128 x = _mm_loadu_ps((const float*)(cols[0] + i * 4));
+      __m128 y = _mm_loadu_ps((const float*)(cols[1] + i * 4));
+      __m128 z = _mm_loadu_ps((const float*)(cols[2] + i * 4));
+      __m128 t = _mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 0, 0, 0));
+      __m128 u = _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0));
+      _mm_storeu_ps((float*)(rows + i * 12), _mm_shuffle_ps(t, u, _MM_SHUFFLE(2, 0, 2, 0)));
+      t = _mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1));
+      u = _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 2, 2, 2));
+      _mm_storeu_ps((float*)(rows + i * 12 + 16), _mm_shuffle_ps(t, u, _MM_SHUFFLE(2, 0, 2, 0)));
+      t = _mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2));
+      u = _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3));
+      _mm_storeu_ps((float*)(rows + i * 12 + 32), _mm_shuffle_ps(t, u, _MM_SHUFFLE(2, 0, 2, 0)));
+    }
+  else if(w == 4 && k == 4)
+    for(; i + 4 <= m; i += 4)
+    {
+      __m128 a = _mm_loadu_ps((const float*)(cols[0] + i * 4));
+      __m128 b = _mm_loadu_ps((const float*)(cols[1] + i * 4));
+      __m128 c = _mm_loadu_ps((const float*)(cols[2] + i * 4));
+      __m128 d = _mm_loadu_ps((const float*)(cols[3] + i * 4));
+      _MM_TRANSPOSE4_PS(a, b, c, d);
+      _mm_storeu_ps((float*)(rows + i * 16), a);
+      _mm_storeu_ps((float*)(rows + i * 16 + 16), b);
+      _mm_storeu_ps((float*)(rows + i * 16 + 32), c);
+      _mm_storeu_ps((float*)(rows + i * 16 + 48), d);
+    }
+  else if(w == 8 && (k == 2 || k == 4))
+    for(; i + 2 <= m; i += 2)
+      for(size_t j = 0; j < k; j += 2)
+      {
+        __m128d x = _mm_loadu_pd((const double*)(cols[j] + i * 8));
+        __m128d y = _mm_loadu_pd((const double*)(cols[j + 1] + i * 8));
+        _mm_storeu_pd((double*)(rows + i * k * 8 + j * 8), _mm_unpacklo_pd(x, y));
+        _mm_storeu_pd((double*)(rows + (i + 1) * k * 8 + j * 8), _mm_unpackhi_pd(x, y));
+      }
+  return i;
+}
+#endif
+
+//the column layout of a struct
+template<class T>
+struct __BinColumnLayout
+{
+  typedef typename BinCodec<T>::field_types Fields;
+  typedef __BinColumnShape<Fields> Shape;
+  typedef __BinColumnCopy<T, Fields> Copy;
+  static const size_t count = Shape::count;
+
+  static_assert(count > 0, "columnar structs need at least one field");
+  static_assert(Shape::raw, "columnar structs can only have plain fields");
+
+  uintptr_t sizes[count];
+  uintptr_t aligns[count];
+  uintptr_t offsets[count];
+  bool dense;
+
+  explicit __BinColumnLayout(const T& obj)
+  {
+    Shape::fill(sizes, aligns);
+    __BinFieldOffsets v = {(const char*)&obj, offsets};
+    BinCodec<T>::fields(obj, v);
+    dense = (Shape::width == 4 || Shape::width == 8) && sizeof(T) == Shape::row;
+    for(size_t c = 0; c < count; ++c)
+      dense = dense && offsets[c] == c * Shape::width;
+  }
+
+  //offsets of the columns of a group of m rows from the start of the group, and the
+  //size of the group
+  static uintptr_t starts(uintptr_t m, const uintptr_t* sizes, const uintptr_t* aligns,
+    uintptr_t* out)
+  {
+    uintptr_t pos = 0;
+    for(size_t c = 0; c < count; ++c)
+    {
+      pos = (pos + aligns[c] - 1) & ~(aligns[c] - 1);
+      out[c] = pos;
+      pos += m * sizes[c];
+    }
+    return pos;
+  }
+
+  void split(const T* rows, uintptr_t m, char* const* cols) const
+  {
+    uintptr_t done = 0;
+#if defined(__SSE2__)
+    if(dense)
+      done = __bin_split_dense((const char*)rows, m, count, Shape::width, cols);
+#endif
+    char* rest[count];
+    for(size_t c = 0; c < count; ++c)
+      rest[c] = cols[c] + done * sizes[c];
+    Copy::split((const char*)(rows + done), m - done, offsets, rest);
+  }
+
+  void join(T* rows, uintptr_t m, const char* const* cols) const
+  {
+    uintptr_t done = 0;
+#if defined(__SSE2__)
+    if(dense)
+      done = __bin_join_dense((char*)rows, m, count, Shape::width, cols);
+#endif
+    const char* rest[count];
+    for(size_t c = 0; c < count; ++c)
+      rest[c] = cols[c] + done * sizes[c];
+    Copy::join((char*)(rows + done), m - done, offsets, rest);
+  }
+};
+
+/**
+  @brief Writes an array of structs as columns, one per field.
+  @param writer The writer to write to.
+  @param data Pointer to the first struct.
+  @param n Number of structs.
+  @param group Number of rows per group. default: bin_column_group
+*/
+template<class W, class T>
+void bin_write_columns(W& writer, const T* data, uintptr_t n,
+  uintptr_t group = bin_column_group)
+{
+  typedef __BinColumnLayout<T> Layout;
+  if(group == 0)
+    group = 1;
+  writer.write_varint(n);
+  writer.write_varint(group);
+  if(n == 0)
+    return;
+
+  Layout layout(data[0]);
+  uintptr_t rows = n < group? n : group;
+  std::unique_ptr<char[]> stage(new char[rows * Layout::Shape::row]);
+  char* cols[Layout::count];
+  for(uintptr_t i = 0; i < n; i += rows)
+  {
+    uintptr_t m = n - i < rows? n - i : rows;
+    uintptr_t pos = 0;
+    for(size_t c = 0; c < Layout::count; ++c)
+    {
+      cols[c] = stage.get() + pos;
+      pos += m * layout.sizes[c];
+    }
+    layout.split(data + i, m, cols);
+    writer.align(Layout::Shape::align);
+    for(size_t c = 0; c < Layout::count; ++c)
+    {
+      writer.align(layout.aligns[c]);
+      writer.write_span(cols[c], m * layout.sizes[c]);
+    }
+  }
+}
+
+/**
+  @brief Reads an array of structs written by bin_write_columns.
+  @param reader The reader to read from.
+  @param out The vector to read into. It is resized to the number of structs.
+  @return false if the data is truncated or malformed.
+*/
+template<class R, class T, class A>
+bool bin_read_columns(R& reader, std::vector<T, A>& out)
+{
+  typedef __BinColumnLayout<T> Layout;
+  uint64_t n = reader.read_varint();
+  uint64_t group = reader.read_varint();
+  if(!reader.good() || group == 0 || n > uint64_t(uintptr_t(-1) / Layout::Shape::row)
+    || !reader.may_contain(uintptr_t(n) * Layout::Shape::row))
+    return false;
+  out.resize(uintptr_t(n));
+  if(n == 0)
+    return true;
+
+  Layout layout(out[0]);
+  uintptr_t rows = n < group? uintptr_t(n) : uintptr_t(group);
+  std::unique_ptr<char[]> stage(new char[rows * Layout::Shape::row]);
+  char* cols[Layout::count];
+  for(uintptr_t i = 0; i < n; i += rows)
+  {
+    uintptr_t m = n - i < rows? uintptr_t(n) - i : rows;
+    uintptr_t pos = 0;
+    reader.align(Layout::Shape::align);
+    for(size_t c = 0; c < Layout::count; ++c)
+    {
+      cols[c] = stage.get() + pos;
+      pos += m * layout.sizes[c];
+      reader.align(layout.aligns[c]);
+      if(!reader.read(cols[c], m * layout.sizes[c]))
+        return false;
+    }
+    layout.join(out.data() + i, m, cols);
+  }
+  return reader.good();
+}
+
+/**
+  @brief Columnar data read in place from a BinDeserializer, for loading only some of
+  the columns.
+
+  The constructor reads past all of the data, so the deserializer can go on reading
+  what follows it. The columns are only touched when they are accessed.
+
+  @param T The struct type, which must be the one written.
+*/
+template<class T>
+class BinColumns
+{
+  typedef __BinColumnLayout<T> Layout;
+  typedef typename Layout::Fields Fields;
+
+  const char* _data = nullptr;
+  uint64_t _rows = 0;
+  uintptr_t _group = 1;
+  uintptr_t _stride = 0;
+  uintptr_t _sizes[Layout::count];
+  uintptr_t _aligns[Layout::count];
+  bool _good = true;
+
+  template<size_t I>
+  uintptr_t _columnStart(uintptr_t g, uintptr_t& m) const
+  {
+    uintptr_t starts[Layout::count];
+    m = group_rows(g);
+    Layout::starts(m, _sizes, _aligns, starts);
+    return g * _stride + starts[I];
+  }
+
+public:
+  /**
+    @brief Constructor
+    @param reader The deserializer, positioned at data written by bin_write_columns.
+    If the data is malformed good() returns false for both.
+  */
+  explicit BinColumns(BinDeserializer& reader)
+  {
+    Layout::Shape::fill(_sizes, _aligns);
+    uint64_t n = reader.read_varint();
+    uint64_t group = reader.read_varint();
+    if(!reader.good() || group == 0
+      || n > reader.remaining() / Layout::Shape::row)
+    {
+      _good = false;
+      return;
+    }
+    if(n == 0)
+      return;
+    uintptr_t starts[Layout::count];
+    _rows = n;
+    _group = n < group? uintptr_t(n) : uintptr_t(group);
+    uintptr_t a = Layout::Shape::align;
+    _stride = (Layout::starts(_group, _sizes, _aligns, starts) + a - 1) & ~(a - 1);
+    uintptr_t last = Layout::starts(group_rows(groups() - 1), _sizes, _aligns, starts);
+    uintptr_t pos = uintptr_t(reader.tell());
+    uintptr_t pad = ((pos + a - 1) & ~(a - 1)) - pos;
+    uintptr_t total = pad + (groups() - 1) * _stride + last;
+    BinView<char> view = reader.view<char>(total);
+    if(view.empty())
+    {
+      _good = false;
+      return;
+    }
+    _data = view.data() + pad;
+  }
+
+  /**
+    @brief Returns false if the data is malformed.
+  */
+  bool good() const
+  {
+    return _good;
+  }
+
+  /**
+    @brief Returns the number of rows.
+  */
+  uint64_t size() const
+  {
+    return _rows;
+  }
+
+  /**
+    @brief Returns the number of groups of rows.
+  */
+  uintptr_t groups() const
+  {
+    return uintptr_t((_rows + _group - 1) / _group);
+  }
+
+  /**
+    @brief Returns the number of rows in a group, which is the same for all groups but
+    the last.
+  */
+  uintptr_t group_rows(uintptr_t g) const
+  {
+    uint64_t left = _rows - uint64_t(g) * _group;
+    return left < _group? uintptr_t(left) : _group;
+  }
+
+  /**
+    @brief Returns a view of a column of a group in place.
+    @param I Index of the field in BIN_FIELDS.
+    @param g Index of the group.
+    @return The column, or an empty view if g is out of range or the data is not
+    aligned for the field type in memory.
+  */
+  template<size_t I>
+  BinView<typename __BinTypeAt<I, Fields>::type> column(uintptr_t g) const
+  {
+    typedef typename __BinTypeAt<I, Fields>::type F;
+    if(g >= groups())
+      return BinView<F>();
+    uintptr_t m;
+    const char* p = _data + _columnStart<I>(g, m);
+    if((uintptr_t)p % alignof(F) != 0)
+      return BinView<F>();
+    return BinView<F>((const F*)p, m);
+  }
+
+  /**
+    @brief Copies a whole column.
+    @param I Index of the field in BIN_FIELDS.
+    @param out Where to copy the column, with room for size() values.
+  */
+  template<size_t I>
+  void read_column(typename __BinTypeAt<I, Fields>::type* out) const
+  {
+    typedef typename __BinTypeAt<I, Fields>::type F;
+    for(uintptr_t g = 0; g < groups(); ++g)
+    {
+      uintptr_t m;
+      const char* p = _data + _columnStart<I>(g, m);
+      memcpy((char*)out, p, m * sizeof(F));
+      out += m;
+    }
+  }
+};
+
+#endif
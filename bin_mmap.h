@@ -0,0 +1,341 @@
+#ifndef BIN_MMAP_H_INCLUDED
+#define BIN_MMAP_H_INCLUDED
+
+/**
+  @file
+  @author Erik Boström <cewbostrom@gmail.com>
+  @date 16.10.2026
+
+  @section LICENSE
+
+  MIT License (MIT)
+
+  Copyright (c) 2015 Erik Boström
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+
+  @section DESCRIPTION
+
+  Serializing straight into a memory mapped file, and deserializing from one in place.
+  POSIX only.
+
+  usage:
+
+  BinMappedWriter has the write functions of BinSerializer. The file grows as it is
+  written to and is truncated to the size of the data when the writer is closed.
+  BinMappedReader is a BinDeserializer reading a mapping of the whole file, so pages
+  are only read from disk as they are touched and views point into the page cache.
+*/
+
+#include <new>
+#include <cstring>
+#include <cstdint>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "bin_serializer.h"
+
+/**
+  @brief Serializer writing into a memory mapped file.
+
+  The file is grown by doubling with ftruncate and remapped with mremap where
+  available, so data already written is never copied. Check good() after
+  construction.
+
+  @note Writes that need the file to grow throw std::bad_alloc if the file can not be
+  grown or mapped. As with any shared file mapping, running out of disk space while
+  pages are written back raises SIGBUS.
+*/
+class BinMappedWriter: public BinWriter<BinMappedWriter>
+{
+  friend class BinWriter<BinMappedWriter>;
+
+  int _fd;
+  char* _data = nullptr;
+  uintptr_t _capacity = 0;
+  uintptr_t _size = 0;
+  uintptr_t _pos = 0;
+  bool _failed = false;
+
+  //on failure the old mapping and its data are kept and the writer is marked not good
+  void _grow(uintptr_t new_size)
+  {
+    uintptr_t new_cap = _capacity? _capacity << 1 : 4096;
+    while(new_cap < new_size)
+      new_cap <<= 1;
+    if(_fd == -1 || ftruncate(_fd, off_t(new_cap)) != 0)
+    {
+      _failed = true;
+      throw std::bad_alloc();
+    }
+
+    void* data;
+#if defined(__linux__) && defined(MREMAP_MAYMOVE)
+    if(_data != nullptr)
+      data = mremap(_data, _capacity, new_cap, MREMAP_MAYMOVE);
+    else
+#endif
+    {
+      data = mmap(nullptr, new_cap, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+      if(data != MAP_FAILED && _data != nullptr)
+        munmap(_data, _capacity);
+    }
+    if(data == MAP_FAILED)
+    {
+      _failed = true;
+      throw std::bad_alloc();
+    }
+    _data = (char*)data;
+    _capacity = new_cap;
+  }
+
+  char* _prepare(uintptr_t len)
+  {
+    if(_pos + len > _capacity)
+      _grow(_pos + len);
+    return _data + _pos;
+  }
+
+  void _advance(uintptr_t len)
+  {
+    _pos += len;
+    if(_pos > _size)
+      _size = _pos;
+  }
+
+public:
+  /**
+    @brief Constructor. Creates or truncates a file.
+    @param path Path of the file.
+    @param capacity Initial size of the file in bytes. default: 1 MiB
+  */
+  explicit BinMappedWriter(const char* path, uintptr_t capacity = uintptr_t(1) << 20)
+  {
+    _fd = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(_fd != -1 && capacity != 0)
+    {
+      try
+      {
+        _grow(capacity);
+      }
+      catch(std::bad_alloc&)
+      {
+        close();
+      }
+    }
+  }
+  BinMappedWriter(const BinMappedWriter&) = delete;
+  void operator=(const BinMappedWriter&) = delete;
+  ~BinMappedWriter()
+  {
+    close();
+  }
+
+  /**
+    @brief Returns false if the file could not be opened, could not be grown or has
+    been closed.
+  */
+  bool good() const
+  {
+    return _fd != -1 && !_failed;
+  }
+
+  /**
+    @brief Returns the number of bytes written.
+  */
+  uintptr_t size() const
+  {
+    return _size;
+  }
+
+  /**
+    @brief Gets a pointer to the mapped data.
+  */
+  char* get()
+  {
+    return _data;
+  }
+
+  /**
+    @brief Moves the position indicator. Works like BinSerializer::seek.
+    @return A reference to the object called.
+  */
+  BinMappedWriter& seek(intptr_t offset, int whence)
+  {
+    intptr_t pos;
+    switch(whence)
+    {
+    case SEEK_CUR:
+      pos = _pos;
+      break;
+    case SEEK_SET:
+      pos = 0;
+      break;
+    case SEEK_END:
+      pos = _size;
+      break;
+    default:
+      return *this;
+    }
+
+    pos += offset;
+    if(pos < 0)
+      pos = 0;
+    else if((uintptr_t)pos > _size)
+      pos = _size;
+    _pos = pos;
+
+    return *this;
+  }
+
+  /**
+    @brief Returns the position indicator in bytes from the beginning of the file.
+  */
+  uintptr_t tell() const
+  {
+    return _pos;
+  }
+
+  /**
+    @brief Writes the data back to the file.
+    @param wait Wait for the write to finish. default: true
+    @return false if msync fails.
+  */
+  bool sync(bool wait = true)
+  {
+    if(_data == nullptr || _size == 0)
+      return true;
+    return msync(_data, _size, wait? MS_SYNC : MS_ASYNC) == 0;
+  }
+
+  /**
+    @brief Unmaps the file, truncates it to the size of the data and closes it.
+    @return false if truncating or closing the file fails.
+  */
+  bool close()
+  {
+    if(_fd == -1)
+      return true;
+    if(_data != nullptr)
+      munmap(_data, _capacity);
+    bool ret = ftruncate(_fd, off_t(_size)) == 0;
+    ret = ::close(_fd) == 0 && ret;
+    _fd = -1;
+    _data = nullptr;
+    _capacity = 0;
+    return ret;
+  }
+};
+
+//owns a read only mapping of a file. a base of BinMappedReader so that it is set up
+//before and torn down after the BinDeserializer reading it
+class __BinMapping
+{
+protected:
+  const char* _map_data = nullptr;
+  uintptr_t _map_size = 0;
+  bool _map_ok = false;
+
+  __BinMapping(const char* path, bool populate)
+  {
+    int fd = ::open(path, O_RDONLY);
+    if(fd == -1)
+      return;
+    struct stat st;
+    if(fstat(fd, &st) == 0)
+    {
+      _map_size = uintptr_t(st.st_size);
+      _map_ok = true;
+      if(_map_size != 0)
+      {
+        int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+        if(populate)
+          flags |= MAP_POPULATE;
+#endif
+        void* data = mmap(nullptr, _map_size, PROT_READ, flags, fd, 0);
+        if(data == MAP_FAILED)
+        {
+          _map_size = 0;
+          _map_ok = false;
+        }
+        else
+        {
+          _map_data = (const char*)data;
+#ifndef MAP_POPULATE
+          if(populate)
+            madvise(data, _map_size, MADV_WILLNEED);
+#endif
+        }
+      }
+    }
+    ::close(fd);
+  }
+  ~__BinMapping()
+  {
+    if(_map_data != nullptr)
+      munmap((void*)_map_data, _map_size);
+  }
+
+public:
+  __BinMapping(const __BinMapping&) = delete;
+  void operator=(const __BinMapping&) = delete;
+};
+
+/**
+  @brief Deserializer reading a memory mapped file in place.
+
+  Reading does not need any read calls or copies: pages are faulted in as they are
+  touched, and views returned by view() point straight into the mapping. good()
+  returns false if the file could not be mapped.
+*/
+class BinMappedReader: private __BinMapping, public BinDeserializer
+{
+public:
+  /**
+    @brief Constructor
+    @param path Path of the file.
+    @param populate Read the whole file into memory up front instead of on demand.
+    default: false
+  */
+  explicit BinMappedReader(const char* path, bool populate = false):
+    __BinMapping(path, populate),
+    BinDeserializer(_map_data, _map_size)
+  {
+    if(!_map_ok)
+      _good = false;
+  }
+  BinMappedReader(const BinMappedReader&) = delete;
+  void operator=(const BinMappedReader&) = delete;
+
+  /**
+    @brief Advises the kernel on how the file is going to be read, see madvise.
+    @param advice MADV_SEQUENTIAL, MADV_RANDOM, MADV_WILLNEED etc.
+  */
+  void advise(int advice)
+  {
+    if(_map_data != nullptr)
+      madvise((void*)_map_data, _map_size, advice);
+  }
+};
+
+#endif
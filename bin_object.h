@@ -0,0 +1,654 @@
+#ifndef BIN_OBJECT_H_INCLUDED
+#define BIN_OBJECT_H_INCLUDED
+
+/**
+  @file
+  @author Erik Boström <cewbostrom@gmail.com>
+  @date 16.10.2026
+
+  @section LICENSE
+
+  MIT License (MIT)
+
+  Copyright (c) 2015 Erik Boström
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+
+  @section DESCRIPTION
+
+  Field by field serialization of objects for the write_object and read_object
+  functions of the binary writers and readers.
+
+  A struct declares its fields once with BIN_FIELDS. Its fields are then written
+  without the padding between them, and fields that are containers or structs with
+  BIN_FIELDS of their own are followed. Runs of plain fields that lie next to each
+  other in memory, also across nested structs, are copied with one memcpy. The field
+  list is a template expansion, so the code generated is the same as if the copies
+  were written by hand.
+
+  Containers are written as a varint length followed by their elements. Supported are
+  arrays, std::array, std::vector, std::basic_string, std::pair, the std sets and maps,
+  SSOVector and RingBuffer. Elements that are plain are copied as one block, and
+  containers are sized exactly before they are read into.
+
+  Plain fields are trivially copyable types without BIN_FIELDS, such as integers,
+  enums and arrays of them. They are copied as raw bytes. A field that is a pointer
+  does not compile, but a plain struct without BIN_FIELDS that holds a pointer is
+  copied as raw bytes like any other, and the address it holds is meaningless when
+  read back. Give such structs BIN_FIELDS that leave the pointer out. Other types
+  can be supported by specializing BinCodec.
+
+  usage:
+
+  struct Point
+  {
+    float x, y;
+    std::string name;
+    std::vector<int> tags;
+
+    BIN_FIELDS(x, y, name, tags)
+  };
+
+  serializer.write_object(point);
+  deserializer.read_object(point);
+
+  BIN_FIELDS must come after the fields. A derived struct must declare its own
+  BIN_FIELDS, listing the fields of the base too.
+*/
+
+#include <vector>
+#include <string>
+#include <array>
+#include <set>
+#include <map>
+#include <unordered_set>
+#include <unordered_map>
+#include <utility>
+#include <type_traits>
+#include <cstddef>
+#include <cstdint>
+
+#include "bin_serializer.h"
+#include "sso_vector.h"
+#include "ring_buffer.h"
+
+template<class... T>
+struct __BinTypeList{};
+
+template<class... T>
+__BinTypeList<T...> __bin_type_list(const T&...);
+
+/**
+  @brief Declares the fields of a struct to be serialized by write_object and
+  read_object, in order. Place it after the fields in the struct body.
+*/
+#define BIN_FIELDS(...) \
+  template<class, class> friend struct ::BinCodec; \
+  template<class> friend struct ::bin_reflected; \
+  typedef decltype(::__bin_type_list(__VA_ARGS__)) __bin_field_types; \
+  template<class __BinF> void __bin_fields(__BinF& f) {f(__VA_ARGS__);} \
+  template<class __BinF> void __bin_fields(__BinF& f) const {f(__VA_ARGS__);}
+
+/**
+  @brief Trait telling whether a type declares its fields with BIN_FIELDS.
+*/
+template<class T>
+struct bin_reflected
+{
+private:
+  template<class U>
+  static std::true_type _test(typename U::__bin_field_types*);
+  template<class U>
+  static std::false_type _test(...);
+
+public:
+  static const bool value = decltype(_test<T>(nullptr))::value;
+};
+
+//true if all types in the list are plain and their sizes add up to size
+template<size_t Size, class List>
+struct __BinPacked;
+
+template<size_t Size>
+struct __BinPacked<Size, __BinTypeList<>>: std::integral_constant<bool, Size == 0>{};
+
+template<size_t Size, class T, class... Rest>
+struct __BinPacked<Size, __BinTypeList<T, Rest...>>: std::integral_constant<bool,
+  BinCodec<T>::raw && sizeof(T) <= Size
+  && __BinPacked<Size - (sizeof(T) <= Size? sizeof(T) : 0), __BinTypeList<Rest...>>::value>{};
+
+/**
+  @brief Serialization of a type by write_object and read_object.
+
+  The primary template copies trivially copyable types as raw bytes. It rejects
+  pointers, but not pointers that are members of the type. Specializations
+  provide
+
+  static const bool raw: true if objects are written as their raw bytes.
+
+  template<class W> static void write(W& writer, const T& obj)
+
+  template<class R> static bool read(R& reader, T& obj), returning false on failure.
+*/
+template<class T, class Enable>
+struct BinCodec
+{
+  static_assert(!std::is_pointer<T>::value, "pointers can not be serialized");
+  static_assert(std::is_trivially_copyable<T>::value,
+    "type has no BinCodec, declare its fields with BIN_FIELDS or specialize BinCodec");
+
+  static const bool raw = true;
+
+  template<class W>
+  static void write(W& writer, const T& obj)
+  {
+    writer.write_span((const char*)&obj, sizeof(T));
+  }
+  template<class R>
+  static bool read(R& reader, T& obj)
+  {
+    return reader.read((char*)&obj, sizeof(T));
+  }
+};
+
+//writes n objects, as one block if they are plain
+template<class W, class T>
+void __bin_write_elements(W& writer, const T* data, uintptr_t n)
+{
+  if(BinCodec<T>::raw)
+    writer.write_span((const char*)data, n * sizeof(T));
+  else for(uintptr_t i = 0; i < n; ++i)
+    BinCodec<T>::write(writer, data[i]);
+}
+
+template<class R, class T>
+bool __bin_read_elements(R& reader, T* data, uintptr_t n)
+{
+  if(BinCodec<T>::raw)
+    return n == 0 || reader.read((char*)data, n * sizeof(T));
+  for(uintptr_t i = 0; i < n; ++i)
+    if(!BinCodec<T>::read(reader, data[i]))
+      return false;
+  return true;
+}
+
+//reads a length prefix and checks that the data can hold that many elements, which
+//take at least one byte each unless they are plain
+template<class T, class R>
+bool __bin_read_length(R& reader, uintptr_t& n)
+{
+  uint64_t len = reader.read_varint();
+  const uintptr_t size = BinCodec<T>::raw? sizeof(T) : 1;
+  if(!reader.good() || len > uint64_t(uintptr_t(-1) / size)
+    || !reader.may_contain(uintptr_t(len) * size))
+    return false;
+  n = uintptr_t(len);
+  return true;
+}
+
+//visits the fields of an object for writing, gathering runs of adjacent plain fields
+template<class W>
+struct __BinFieldWriter
+{
+  W& writer;
+  const char* run;
+  uintptr_t len;
+
+  void flush()
+  {
+    if(len)
+      writer.write_span(run, len);
+    len = 0;
+  }
+
+  template<class T>
+  void _field(const T& f, std::true_type)
+  {
+    const char* p = (const char*)&f;
+    if(len && run + len == p)
+      len += sizeof(T);
+    else
+    {
+      flush();
+      run = p;
+      len = sizeof(T);
+    }
+  }
+  template<class T>
+  void _field(const T& f, std::false_type)
+  {
+    _nested(f, std::integral_constant<bool, bin_reflected<T>::value>());
+  }
+  template<class T>
+  void _nested(const T& f, std::true_type)
+  {
+    BinCodec<T>::fields(f, *this);
+  }
+  template<class T>
+  void _nested(const T& f, std::false_type)
+  {
+    flush();
+    BinCodec<T>::write(writer, f);
+  }
+
+  void operator()(){}
+  template<class T, class... Rest>
+  void operator()(const T& f, const Rest&... rest)
+  {
+    _field(f, std::integral_constant<bool, BinCodec<T>::raw>());
+    (*this)(rest...);
+  }
+};
+
+template<class R>
+struct __BinFieldReader
+{
+  R& reader;
+  char* run;
+  uintptr_t len;
+  bool ok;
+
+  void flush()
+  {
+    if(len && ok)
+      ok = reader.read(run, len);
+    len = 0;
+  }
+
+  template<class T>
+  void _field(T& f, std::true_type)
+  {
+    char* p = (char*)&f;
+    if(len && run + len == p)
+      len += sizeof(T);
+    else
+    {
+      flush();
+      run = p;
+      len = sizeof(T);
+    }
+  }
+  template<class T>
+  void _field(T& f, std::false_type)
+  {
+    _nested(f, std::integral_constant<bool, bin_reflected<T>::value>());
+  }
+  template<class T>
+  void _nested(T& f, std::true_type)
+  {
+    BinCodec<T>::fields(f, *this);
+  }
+  template<class T>
+  void _nested(T& f, std::false_type)
+  {
+    flush();
+    ok = ok && BinCodec<T>::read(reader, f);
+  }
+
+  void operator()(){}
+  template<class T, class... Rest>
+  void operator()(T& f, Rest&... rest)
+  {
+    _field(f, std::integral_constant<bool, BinCodec<T>::raw>());
+    (*this)(rest...);
+  }
+};
+
+/**
+  @brief Serialization of structs declaring their fields with BIN_FIELDS. Structs whose
+  fields are all plain and have no padding between them are plain themselves.
+*/
+template<class T>
+struct BinCodec<T, typename std::enable_if<bin_reflected<T>::value>::type>
+{
+  static const bool raw = std::is_trivially_copyable<T>::value
+    && __BinPacked<sizeof(T), typename T::__bin_field_types>::value;
+
+  //the types of the fields, as a __BinTypeList
+  typedef typename T::__bin_field_types field_types;
+
+  template<class F>
+  static void fields(const T& obj, F& f)
+  {
+    obj.__bin_fields(f);
+  }
+  template<class F>
+  static void fields(T& obj, F& f)
+  {
+    obj.__bin_fields(f);
+  }
+
+  template<class W>
+  static void write(W& writer, const T& obj)
+  {
+    __BinFieldWriter<W> v = {writer, nullptr, 0};
+    fields(obj, v);
+    v.flush();
+  }
+  template<class R>
+  static bool read(R& reader, T& obj)
+  {
+    __BinFieldReader<R> v = {reader, nullptr, 0, true};
+    fields(obj, v);
+    v.flush();
+    return v.ok;
+  }
+};
+
+/**
+  @brief Serialization of arrays, element by element unless the elements are plain.
+*/
+template<class T, size_t N>
+struct BinCodec<T[N]>
+{
+  static const bool raw = BinCodec<T>::raw;
+
+  template<class W>
+  static void write(W& writer, const T (&obj)[N])
+  {
+    __bin_write_elements(writer, obj, N);
+  }
+  template<class R>
+  static bool read(R& reader, T (&obj)[N])
+  {
+    return __bin_read_elements(reader, obj, N);
+  }
+};
+
+/**
+  @brief Serialization of vectors as a varint length followed by the elements.
+*/
+template<class T, class A>
+struct BinCodec<std::vector<T, A>>
+{
+  static const bool raw = false;
+
+  template<class W>
+  static void write(W& writer, const std::vector<T, A>& obj)
+  {
+    writer.write_varint(obj.size());
+    __bin_write_elements(writer, obj.data(), obj.size());
+  }
+  template<class R>
+  static bool read(R& reader, std::vector<T, A>& obj)
+  {
+    uintptr_t n;
+    if(!__bin_read_length<T>(reader, n))
+      return false;
+    obj.resize(n);
+    return __bin_read_elements(reader, obj.data(), n);
+  }
+};
+
+template<class A>
+struct BinCodec<std::vector<bool, A>>
+{
+  static const bool raw = false;
+
+  template<class W>
+  static void write(W& writer, const std::vector<bool, A>& obj)
+  {
+    writer.write_varint(obj.size());
+    for(bool b: obj)
+      writer.write(uint8_t(b));
+  }
+  template<class R>
+  static bool read(R& reader, std::vector<bool, A>& obj)
+  {
+    uintptr_t n;
+    if(!__bin_read_length<uint8_t>(reader, n))
+      return false;
+    obj.resize(n);
+    for(uintptr_t i = 0; i < n; ++i)
+      obj[i] = reader.template read<uint8_t>() != 0;
+    return reader.good();
+  }
+};
+
+/**
+  @brief Serialization of strings as a varint length followed by the characters.
+*/
+template<class C, class Tr, class A>
+struct BinCodec<std::basic_string<C, Tr, A>>
+{
+  static const bool raw = false;
+
+  template<class W>
+  static void write(W& writer, const std::basic_string<C, Tr, A>& obj)
+  {
+    writer.write_varint(obj.size());
+    writer.write_span(obj.data(), obj.size());
+  }
+  template<class R>
+  static bool read(R& reader, std::basic_string<C, Tr, A>& obj)
+  {
+    uintptr_t n;
+    if(!__bin_read_length<C>(reader, n))
+      return false;
+    obj.resize(n);
+    return n == 0 || reader.read(&obj[0], n);
+  }
+};
+
+/**
+  @brief Serialization of std::array, like arrays.
+*/
+template<class T, size_t N>
+struct BinCodec<std::array<T, N>>
+{
+  static const bool raw = BinCodec<T>::raw && sizeof(std::array<T, N>) == sizeof(T) * N;
+
+  template<class W>
+  static void write(W& writer, const std::array<T, N>& obj)
+  {
+    __bin_write_elements(writer, obj.data(), N);
+  }
+  template<class R>
+  static bool read(R& reader, std::array<T, N>& obj)
+  {
+    return __bin_read_elements(reader, obj.data(), N);
+  }
+};
+
+/**
+  @brief Serialization of pairs as the first element followed by the second.
+*/
+template<class A, class B>
+struct BinCodec<std::pair<A, B>>
+{
+  static const bool raw = false;
+
+  template<class W>
+  static void write(W& writer, const std::pair<A, B>& obj)
+  {
+    BinCodec<A>::write(writer, obj.first);
+    BinCodec<B>::write(writer, obj.second);
+  }
+  template<class R>
+  static bool read(R& reader, std::pair<A, B>& obj)
+  {
+    return BinCodec<A>::read(reader, obj.first) && BinCodec<B>::read(reader, obj.second);
+  }
+};
+
+template<class C>
+auto __bin_reserve(C& obj, uintptr_t n, int) -> decltype(obj.reserve(n), void())
+{
+  obj.reserve(n);
+}
+template<class C>
+void __bin_reserve(C&, uintptr_t, long){}
+
+//serialization of sets as a varint length followed by the elements in iteration
+//order. ordered sets are read back in linear time since the elements come in order
+template<class C>
+struct __BinSetCodec
+{
+  typedef typename C::key_type Key;
+
+  static const bool raw = false;
+
+  template<class W>
+  static void write(W& writer, const C& obj)
+  {
+    writer.write_varint(obj.size());
+    for(const Key& key: obj)
+      BinCodec<Key>::write(writer, key);
+  }
+  template<class R>
+  static bool read(R& reader, C& obj)
+  {
+    uintptr_t n;
+    if(!__bin_read_length<Key>(reader, n))
+      return false;
+    obj.clear();
+    __bin_reserve(obj, n, 0);
+    for(uintptr_t i = 0; i < n; ++i)
+    {
+      Key key = Key();
+      if(!BinCodec<Key>::read(reader, key))
+        return false;
+      obj.emplace_hint(obj.end(), std::move(key));
+    }
+    return true;
+  }
+};
+
+//serialization of maps as a varint length followed by the keys and values
+template<class C>
+struct __BinMapCodec
+{
+  typedef typename C::key_type Key;
+  typedef typename C::mapped_type Value;
+
+  static const bool raw = false;
+
+  template<class W>
+  static void write(W& writer, const C& obj)
+  {
+    writer.write_varint(obj.size());
+    for(const typename C::value_type& elem: obj)
+    {
+      BinCodec<Key>::write(writer, elem.first);
+      BinCodec<Value>::write(writer, elem.second);
+    }
+  }
+  template<class R>
+  static bool read(R& reader, C& obj)
+  {
+    uintptr_t n;
+    if(!__bin_read_length<std::pair<Key, Value>>(reader, n))
+      return false;
+    obj.clear();
+    __bin_reserve(obj, n, 0);
+    for(uintptr_t i = 0; i < n; ++i)
+    {
+      Key key = Key();
+      Value value = Value();
+      if(!BinCodec<Key>::read(reader, key) || !BinCodec<Value>::read(reader, value))
+        return false;
+      obj.emplace_hint(obj.end(), std::move(key), std::move(value));
+    }
+    return true;
+  }
+};
+
+template<class K, class Cmp, class A>
+struct BinCodec<std::set<K, Cmp, A>>: __BinSetCodec<std::set<K, Cmp, A>>{};
+template<class K, class Cmp, class A>
+struct BinCodec<std::multiset<K, Cmp, A>>: __BinSetCodec<std::multiset<K, Cmp, A>>{};
+template<class K, class H, class E, class A>
+struct BinCodec<std::unordered_set<K, H, E, A>>:
+  __BinSetCodec<std::unordered_set<K, H, E, A>>{};
+template<class K, class H, class E, class A>
+struct BinCodec<std::unordered_multiset<K, H, E, A>>:
+  __BinSetCodec<std::unordered_multiset<K, H, E, A>>{};
+
+template<class K, class V, class Cmp, class A>
+struct BinCodec<std::map<K, V, Cmp, A>>: __BinMapCodec<std::map<K, V, Cmp, A>>{};
+template<class K, class V, class Cmp, class A>
+struct BinCodec<std::multimap<K, V, Cmp, A>>: __BinMapCodec<std::multimap<K, V, Cmp, A>>{};
+template<class K, class V, class H, class E, class A>
+struct BinCodec<std::unordered_map<K, V, H, E, A>>:
+  __BinMapCodec<std::unordered_map<K, V, H, E, A>>{};
+template<class K, class V, class H, class E, class A>
+struct BinCodec<std::unordered_multimap<K, V, H, E, A>>:
+  __BinMapCodec<std::unordered_multimap<K, V, H, E, A>>{};
+
+/**
+  @brief Serialization of SSOVector as a varint length followed by the elements.
+*/
+template<class T, int Size>
+struct BinCodec<SSOVector<T, Size>>
+{
+  static const bool raw = false;
+
+  template<class W>
+  static void write(W& writer, const SSOVector<T, Size>& obj)
+  {
+    writer.write_varint(obj.size());
+    __bin_write_elements(writer, obj.data(), obj.size());
+  }
+  template<class R>
+  static bool read(R& reader, SSOVector<T, Size>& obj)
+  {
+    uintptr_t n;
+    if(!__bin_read_length<T>(reader, n))
+      return false;
+    obj.resize(n);
+    return __bin_read_elements(reader, obj.data(), n);
+  }
+};
+
+/**
+  @brief Serialization of RingBuffer as a varint length followed by the elements from
+  front to back. The elements are written as the two arrays they are stored in.
+*/
+template<class T>
+struct BinCodec<RingBuffer<T>>
+{
+  static const bool raw = false;
+
+  template<class W>
+  static void write(W& writer, const RingBuffer<T>& obj)
+  {
+    std::pair<T*, size_t> one = obj.array_one();
+    std::pair<T*, size_t> two = obj.array_two();
+    writer.write_varint(one.second + two.second);
+    __bin_write_elements(writer, (const T*)one.first, one.second);
+    __bin_write_elements(writer, (const T*)two.first, two.second);
+  }
+  template<class R>
+  static bool read(R& reader, RingBuffer<T>& obj)
+  {
+    uintptr_t n;
+    if(!__bin_read_length<T>(reader, n))
+      return false;
+    obj.clear();
+    obj.reserve(n);
+    for(uintptr_t i = 0; i < n; ++i)
+      obj.emplace_back();
+    std::pair<T*, size_t> one = obj.array_one();
+    std::pair<T*, size_t> two = obj.array_two();
+    return __bin_read_elements(reader, one.first, one.second)
+      && __bin_read_elements(reader, two.first, two.second);
+  }
+};
+
+#endif
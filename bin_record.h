@@ -0,0 +1,362 @@
+#ifndef BIN_RECORD_H_INCLUDED
+#define BIN_RECORD_H_INCLUDED
+
+/**
+  @file
+  @author Erik Boström <cewbostrom@gmail.com>
+  @date 16.10.2026
+
+  @section LICENSE
+
+  MIT License (MIT)
+
+  Copyright (c) 2015 Erik Boström
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+
+  @section DESCRIPTION
+
+  Framing of variable-length records, with an index at the end for jumping straight to
+  any record.
+
+  layout, all integers in host byte order:
+
+  records, each a varint length followed by its bytes, then for each record the
+  distance from its start to the start of the next as a varint, then a checkpoint for
+  every bin_record_checkpoint records holding the offset of the record (uint64_t) and
+  of its distance in the varints (uint64_t), then a footer of the offset of the
+  varints (uint64_t), the offset of the checkpoints (uint64_t), the number of records
+  (uint64_t), the checkpoint interval (uint32_t) and bin_record_magic (uint32_t).
+  Offsets are relative to the start of the first record.
+
+  Finding a record reads its checkpoint and sums at most the interval minus one
+  distances, so it takes constant time and never touches the data of other records.
+
+  usage:
+
+  BinRecordWriter wraps any writer and has the write functions of BinSerializer, which
+  write to the current record. end_record() closes it, write_record() writes a whole
+  record at once, and finish() or the destructor writes the index. BinRecordReader
+  reads the result from memory, returning each record as a view or a BinDeserializer.
+*/
+
+#include <memory>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+
+#include "bin_serializer.h"
+
+/**
+  @brief Last word of a record stream.
+*/
+const uint32_t bin_record_magic = 0x31435242;
+
+/**
+  @brief Size in bytes of the footer of a record stream.
+*/
+const uintptr_t bin_record_footer_size = 32;
+
+/**
+  @brief Default number of records between checkpoints of the record index.
+*/
+const uint32_t bin_record_checkpoint = 64;
+
+/**
+  @brief Writer framing its data as records, followed by an index of the records.
+  @param Out Type of the writer the records are written to.
+*/
+template<class Out>
+class BinRecordWriter: public BinWriter<BinRecordWriter<Out>>
+{
+  friend class BinWriter<BinRecordWriter<Out>>;
+
+  Out& _out;
+  uint32_t _interval;
+  std::unique_ptr<char[]> _buffer;
+  uintptr_t _capacity = 0;
+  uintptr_t _used = 0;
+  std::vector<uint64_t> _sizes;
+  uint64_t _offset = 0;
+  bool _finished = false;
+
+  char* _prepare(uintptr_t len)
+  {
+    if(_capacity - _used < len)
+    {
+      uintptr_t new_cap = _capacity? _capacity << 1 : 256;
+      while(new_cap - _used < len)
+        new_cap <<= 1;
+      std::unique_ptr<char[]> buffer(new char[new_cap]);
+      if(_used != 0)
+        memcpy(buffer.get(), _buffer.get(), _used);
+      _buffer = std::move(buffer);
+      _capacity = new_cap;
+    }
+    return _buffer.get() + _used;
+  }
+
+  void _advance(uintptr_t len)
+  {
+    _used += len;
+  }
+
+  void _writeRecord(const void* data, uintptr_t len)
+  {
+    uint64_t start = _out.tell();
+    _out.write_varint(len);
+    _out.write_span((const char*)data, len);
+    uint64_t size = _out.tell() - start;
+    _sizes.push_back(size);
+    _offset += size;
+  }
+
+public:
+  /**
+    @brief Constructor
+    @param out The writer to write the records to. It must outlive this object.
+    @param interval Number of records between checkpoints in the index. Smaller
+    intervals make finding a record faster and the index larger.
+    default: bin_record_checkpoint
+  */
+  BinRecordWriter(Out& out, uint32_t interval = bin_record_checkpoint):
+    _out(out),
+    _interval(interval? interval : 1)
+  {}
+  BinRecordWriter(const BinRecordWriter&) = delete;
+  void operator=(const BinRecordWriter&) = delete;
+  ~BinRecordWriter()
+  {
+    finish();
+  }
+
+  /**
+    @brief Returns the number of bytes written to the current record.
+  */
+  uintptr_t tell() const
+  {
+    return _used;
+  }
+
+  /**
+    @brief Returns the number of records written.
+  */
+  uint64_t records() const
+  {
+    return _sizes.size();
+  }
+
+  /**
+    @brief Writes a record at once. If anything has been written to the current
+    record, it is ended first so that the records keep the order of the calls.
+    @param data Pointer to the bytes of the record.
+    @param len Size of the record in bytes.
+    @return A reference to the object called.
+  */
+  BinRecordWriter& write_record(const void* data, uintptr_t len)
+  {
+    if(_used != 0)
+      end_record();
+    _writeRecord(data, len);
+    return *this;
+  }
+
+  /**
+    @brief Ends the current record, which may be empty, and starts a new one.
+    @return A reference to the object called.
+  */
+  BinRecordWriter& end_record()
+  {
+    _writeRecord(_buffer.get(), _used);
+    _used = 0;
+    return *this;
+  }
+
+  /**
+    @brief Ends the current record if anything has been written to it, then writes the
+    index and the footer. Nothing can be written afterwards.
+  */
+  void finish()
+  {
+    if(_finished)
+      return;
+    if(_used != 0)
+      end_record();
+    _finished = true;
+
+    uint64_t varints_offset = _offset;
+    uint64_t varints_start = _out.tell();
+    std::vector<uint64_t> checkpoints;
+    checkpoints.reserve((_sizes.size() + _interval - 1) / _interval * 2);
+    uint64_t offset = 0;
+    for(size_t i = 0; i < _sizes.size(); ++i)
+    {
+      if(i % _interval == 0)
+      {
+        checkpoints.push_back(offset);
+        checkpoints.push_back(_out.tell() - varints_start);
+      }
+      _out.write_varint(_sizes[i]);
+      offset += _sizes[i];
+    }
+    uint64_t checkpoints_offset = varints_offset + (_out.tell() - varints_start);
+    _out.write_vector(checkpoints);
+    _out.write(varints_offset);
+    _out.write(checkpoints_offset);
+    _out.write(uint64_t(_sizes.size()));
+    _out.write(_interval);
+    _out.write(bin_record_magic);
+  }
+};
+
+/**
+  @brief Reader for data written by BinRecordWriter.
+
+  good() is false if the footer is malformed or a record has been found to be.
+*/
+class BinRecordReader
+{
+  const char* _data = nullptr;
+  uint64_t _varints_offset = 0;
+  uint64_t _checkpoints_offset = 0;
+  uint64_t _records = 0;
+  uint64_t _checkpoints = 0;
+  uint32_t _interval = 1;
+  bool _good = true;
+
+  //returns the offset of a record, or _varints_offset if the index is corrupt
+  uint64_t _find(uint64_t n)
+  {
+    if(n / _interval >= _checkpoints)
+    {
+      _good = false;
+      return _varints_offset;
+    }
+    uint64_t checkpoint[2];
+    memcpy(checkpoint, _data + _checkpoints_offset + n / _interval * 16, 16);
+    uint64_t offset = checkpoint[0];
+    if(checkpoint[1] > _checkpoints_offset - _varints_offset)
+      return _varints_offset;
+    const uint8_t* p = (const uint8_t*)_data + _varints_offset + checkpoint[1];
+    const uint8_t* end = (const uint8_t*)_data + _checkpoints_offset;
+    for(uint32_t i = n % _interval; i > 0 && offset < _varints_offset; --i)
+    {
+      uint64_t size;
+      size_t len = bin_varint_decode(p, end - p, size);
+      if(len == 0 || size > _varints_offset - offset)
+        return _varints_offset;
+      p += len;
+      offset += size;
+    }
+    return offset;
+  }
+
+public:
+  /**
+    @brief Constructor. Reads from memory which must outlive the object.
+    @param data Pointer to the start of the first record.
+    @param size Size in bytes of the data, up to and including the footer.
+  */
+  BinRecordReader(const char* data, uintptr_t size)
+  {
+    uint64_t varints_offset, checkpoints_offset, records;
+    uint32_t interval, magic;
+    if(size < bin_record_footer_size)
+    {
+      _good = false;
+      return;
+    }
+    const char* footer = data + size - bin_record_footer_size;
+    memcpy(&varints_offset, footer, 8);
+    memcpy(&checkpoints_offset, footer + 8, 8);
+    memcpy(&records, footer + 16, 8);
+    memcpy(&interval, footer + 24, 4);
+    memcpy(&magic, footer + 28, 4);
+    uint64_t body = size - bin_record_footer_size;
+    if(magic != bin_record_magic || interval == 0 || varints_offset > checkpoints_offset
+      || checkpoints_offset > body
+      || (body - checkpoints_offset) / 16 != records / interval + (records % interval != 0)
+      || (body - checkpoints_offset) % 16 != 0)
+    {
+      _good = false;
+      return;
+    }
+    _data = data;
+    _varints_offset = varints_offset;
+    _checkpoints_offset = checkpoints_offset;
+    _records = records;
+    _checkpoints = (body - checkpoints_offset) / 16;
+    _interval = interval;
+  }
+
+  /**
+    @brief Returns false if the data is malformed.
+  */
+  bool good() const
+  {
+    return _good;
+  }
+
+  /**
+    @brief Returns the number of records.
+  */
+  uint64_t size() const
+  {
+    return _records;
+  }
+
+  /**
+    @brief Returns a view of the bytes of a record.
+    @param n Index of the record.
+    @return The record, or an empty view if n is out of range or the record is
+    malformed, in which case good() becomes false.
+  */
+  BinView<char> record(uint64_t n)
+  {
+    if(n >= _records)
+    {
+      _good = false;
+      return BinView<char>();
+    }
+    uint64_t offset = _find(n);
+    uint64_t size;
+    size_t len = offset < _varints_offset? bin_varint_decode(
+      (const uint8_t*)_data + offset, _varints_offset - offset, size) : 0;
+    if(len == 0 || size > _varints_offset - offset - len)
+    {
+      _good = false;
+      return BinView<char>();
+    }
+    return BinView<char>(_data + offset + len, uintptr_t(size));
+  }
+
+  /**
+    @brief Returns a deserializer reading a record.
+    @param n Index of the record.
+    @return A deserializer over the record, which is empty if n is out of range or
+    the record is malformed.
+  */
+  BinDeserializer reader(uint64_t n)
+  {
+    BinView<char> view = record(n);
+    return BinDeserializer(view.data(), view.size());
+  }
+};
+
+#endif
@@ -0,0 +1,390 @@
+#ifndef BIN_SECTIONS_H_INCLUDED
+#define BIN_SECTIONS_H_INCLUDED
+
+/**
+  @file
+  @author Erik Boström <cewbostrom@gmail.com>
+  @date 16.10.2026
+
+  @section LICENSE
+
+  MIT License (MIT)
+
+  Copyright (c) 2015 Erik Boström
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+
+  @section DESCRIPTION
+
+  Parallel serialization of independent sections of data. Each section is written by
+  a callback into a BinSerializer of its own, on a pool of threads. The offsets of the
+  sections in the output are then a prefix sum of their sizes, and the output is a
+  directory of the sections followed by the sections. A reader finds any section
+  through the directory without reading the others.
+
+  The output can be copied into one buffer, in parallel, or handed on without copying
+  as a list of segments, for example to writev() as iovecs.
+
+  layout, all integers in host byte order:
+
+  bin_section_magic (uint32_t), the number of sections (uint32_t), then for each
+  section its offset from the start of the data (uint64_t) and its size (uint64_t),
+  then the sections, each starting at a multiple of bin_section_align bytes.
+
+  usage:
+
+  BinSections sections(count, [&](size_t i, BinSerializer& out)
+  {
+    ...
+  });
+  writev(fd, sections.iovecs().data(), ...);
+
+  BinSectionReader reader(data, size);
+  BinDeserializer section = reader.reader(3);
+*/
+
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+
+#include "bin_serializer.h"
+
+/**
+  @brief First word of sectioned data.
+*/
+const uint32_t bin_section_magic = 0x31435342;
+
+/**
+  @brief Alignment in bytes of the sections in sectioned data.
+*/
+const uintptr_t bin_section_align = 8;
+
+//runs f(i) for every i below count on up to threads threads, the calling thread
+//included. rethrows the first exception thrown by f after all threads have stopped
+template<class F>
+void __bin_parallel_for(size_t count, unsigned threads, F& f)
+{
+  if(threads == 0)
+    threads = std::thread::hardware_concurrency();
+  if(threads == 0)
+    threads = 1;
+  if(threads > count)
+    threads = unsigned(count);
+
+  std::atomic<size_t> next(0);
+  std::exception_ptr error;
+  std::mutex error_lock;
+  auto work = [&]()
+  {
+    for(;;)
+    {
+      size_t i = next++;
+      if(i >= count)
+        return;
+      try
+      {
+        f(i);
+      }
+      catch(...)
+      {
+        std::lock_guard<std::mutex> lock(error_lock);
+        if(!error)
+          error = std::current_exception();
+        next = count;
+      }
+    }
+  };
+
+  std::vector<std::thread> pool;
+  for(unsigned t = 1; t < threads; ++t)
+    pool.emplace_back(work);
+  work();
+  for(std::thread& t: pool)
+    t.join();
+  if(error)
+    std::rethrow_exception(error);
+}
+
+/**
+  @brief Sections of data serialized in parallel.
+*/
+class BinSections
+{
+  std::vector<BinSerializer> _sections;
+  std::vector<uint64_t> _offsets;
+  BinSerializer _directory;
+  uint64_t _size = 0;
+
+  static const char* _zeros()
+  {
+    static const char zeros[bin_section_align] = {};
+    return zeros;
+  }
+
+  uintptr_t _padding(size_t i) const
+  {
+    uint64_t end = i + 1 < _offsets.size()? _offsets[i + 1] : _size;
+    return uintptr_t(end - _offsets[i] - _sections[i].size());
+  }
+
+public:
+  /**
+    @brief Constructor. Serializes the sections.
+    @param count Number of sections.
+    @param f Called as f(size_t i, BinSerializer& out) to write section i to out,
+    once for every section, from several threads at once. If it throws, the first
+    exception is rethrown once all threads have stopped.
+    @param threads Most threads to use, the calling thread included. 0 for one per
+    hardware thread. default: 0
+  */
+  template<class F>
+  BinSections(size_t count, F f, unsigned threads = 0):
+    _sections(count),
+    _offsets(count),
+    _directory(0)
+  {
+    auto write = [this, &f](size_t i)
+    {
+      f(i, _sections[i]);
+    };
+    __bin_parallel_for(count, threads, write);
+
+    uint64_t offset = 8 + uint64_t(count) * 16;
+    for(size_t i = 0; i < count; ++i)
+    {
+      _offsets[i] = offset;
+      offset += _sections[i].size();
+      offset = (offset + bin_section_align - 1) & ~uint64_t(bin_section_align - 1);
+    }
+    _size = offset;
+
+    _directory.reserve(8 + count * 16);
+    _directory.write(bin_section_magic);
+    _directory.write(uint32_t(count));
+    for(size_t i = 0; i < count; ++i)
+    {
+      _directory.write(_offsets[i]);
+      _directory.write(uint64_t(_sections[i].size()));
+    }
+  }
+
+  /**
+    @brief Returns the number of sections.
+  */
+  size_t count() const
+  {
+    return _sections.size();
+  }
+
+  /**
+    @brief Returns the size in bytes of the data, directory and padding included.
+  */
+  uint64_t size() const
+  {
+    return _size;
+  }
+
+  /**
+    @brief Returns the offset of a section from the start of the data.
+  */
+  uint64_t offset(size_t i) const
+  {
+    return _offsets[i];
+  }
+
+  /**
+    @brief Returns the serializer a section was written to.
+  */
+  BinSerializer& section(size_t i)
+  {
+    return _sections[i];
+  }
+
+  /**
+    @brief Calls f(const char* data, uintptr_t size) for every piece of the data in
+    order: the directory, the sections and the padding between them.
+  */
+  template<class F>
+  void for_each_segment(F f)
+  {
+    f((const char*)_directory.get(), _directory.size());
+    for(size_t i = 0; i < _sections.size(); ++i)
+    {
+      if(_sections[i].size())
+        f((const char*)_sections[i].get(), _sections[i].size());
+      if(_padding(i))
+        f(_zeros(), _padding(i));
+    }
+  }
+
+#if defined(__unix__) || defined(__APPLE__)
+  /**
+    @brief Returns the data as an iovec list for writev(), without copying it.
+    @note writev() accepts at most IOV_MAX entries per call.
+  */
+  std::vector<struct iovec> iovecs()
+  {
+    std::vector<struct iovec> ret;
+    ret.reserve(_sections.size() * 2 + 1);
+    for_each_segment([&ret](const char* data, uintptr_t size)
+    {
+      struct iovec v;
+      v.iov_base = (void*)data;
+      v.iov_len = size;
+      ret.push_back(v);
+    });
+    return ret;
+  }
+#endif
+
+  /**
+    @brief Writes the data to a writer, section by section.
+  */
+  template<class W>
+  void write_to(W& writer)
+  {
+    for_each_segment([&writer](const char* data, uintptr_t size)
+    {
+      writer.write_span(data, size);
+    });
+  }
+
+  /**
+    @brief Copies the data into dest, which must have room for size() bytes. The
+    sections are copied in parallel.
+    @param threads Most threads to use, as for the constructor. default: 0
+  */
+  void copy_to(char* dest, unsigned threads = 0)
+  {
+    memcpy(dest, _directory.get(), _directory.size());
+    auto copy = [this, dest](size_t i)
+    {
+      char* p = dest + _offsets[i];
+      uintptr_t size = _sections[i].size();
+      if(size)
+        memcpy(p, _sections[i].get(), size);
+      memset(p + size, 0, _padding(i));
+    };
+    __bin_parallel_for(_sections.size(), threads, copy);
+  }
+
+  /**
+    @brief Returns the data copied into a BinSerializer with the position indicator at
+    the end.
+  */
+  BinSerializer flatten()
+  {
+    BinSerializer ret(0);
+    ret.reserve(uintptr_t(_size));
+    write_to(ret);
+    return ret;
+  }
+};
+
+/**
+  @brief Reader of data written by BinSections.
+
+  good() is false if the directory is malformed.
+*/
+class BinSectionReader
+{
+  const char* _data = nullptr;
+  uint32_t _count = 0;
+  bool _good = true;
+
+public:
+  /**
+    @brief Constructor. Reads from memory which must outlive the object.
+    @param data Pointer to the data.
+    @param size Size in bytes of the data.
+  */
+  BinSectionReader(const char* data, uintptr_t size)
+  {
+    uint32_t magic, count;
+    if(size < 8)
+    {
+      _good = false;
+      return;
+    }
+    memcpy(&magic, data, 4);
+    memcpy(&count, data + 4, 4);
+    if(magic != bin_section_magic || (size - 8) / 16 < count)
+    {
+      _good = false;
+      return;
+    }
+    for(uint32_t i = 0; i < count; ++i)
+    {
+      uint64_t entry[2];
+      memcpy(entry, data + 8 + uintptr_t(i) * 16, 16);
+      if(entry[0] > size || entry[1] > size - entry[0])
+      {
+        _good = false;
+        return;
+      }
+    }
+    _data = data;
+    _count = count;
+  }
+
+  /**
+    @brief Returns false if the data is malformed.
+  */
+  bool good() const
+  {
+    return _good;
+  }
+
+  /**
+    @brief Returns the number of sections.
+  */
+  size_t count() const
+  {
+    return _count;
+  }
+
+  /**
+    @brief Returns a view of the bytes of a section, or an empty view if i is out of
+    range.
+  */
+  BinView<char> section(size_t i) const
+  {
+    if(i >= _count)
+      return BinView<char>();
+    uint64_t entry[2];
+    memcpy(entry, _data + 8 + i * 16, 16);
+    return BinView<char>(_data + entry[0], uintptr_t(entry[1]));
+  }
+
+  /**
+    @brief Returns a deserializer reading a section, which is empty if i is out of
+    range.
+  */
+  BinDeserializer reader(size_t i) const
+  {
+    BinView<char> view = section(i);
+    return BinDeserializer(view.data(), view.size());
+  }
+};
+
+#endif
@@ -32,265 +32,1556 @@
   
   @section DESCRIPTION
   
-  A class for serializing data into binary buffers.
+  A class for serializing data into binary buffers, and one for reading them back.
+  SegmentedBinSerializer writes into a chain of blocks instead of one growing buffer.
+  
+  Plain writes copy memory as it is, so the data has the byte order of the host. For
+  data that moves between hosts, write_le and write_be and the matching reads store
+  numbers in a fixed byte order, and varints do not depend on byte order. Writes in
+  the byte order of the host are plain copies.
 */
 
 #include <memory>
+#include <type_traits>
+#include <iterator>
+#include <vector>
+#include <string>
 
 #include <cstring>
 #include <cstdio>
+#include <cstdint>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/uio.h>
+#endif
+
+#include "bin_codec.h"
 
 /**
-  @brief Class for serializing binary data.
+  @brief Trait telling BinSerializer that an iterator type points into contiguous
+  memory, so that ranges of it can be copied with a single memcpy.
+  
+  True for pointers and for the iterators of std::vector and std::string. Specialize it
+  for other contiguous iterators.
+*/
+template<class It, class V>
+struct __BinVectorIterator: std::integral_constant<bool,
+  std::is_same<It, typename std::vector<V>::iterator>::value
+  || std::is_same<It, typename std::vector<V>::const_iterator>::value>{};
+
+template<class It>
+struct __BinVectorIterator<It, bool>: std::false_type{};
+
+template<class It>
+struct bin_contiguous_iterator: std::integral_constant<bool,
+  std::is_pointer<It>::value
+  || std::is_same<It, std::string::iterator>::value
+  || std::is_same<It, std::string::const_iterator>::value
+  || __BinVectorIterator<It, typename std::remove_cv<typename std::remove_reference<
+    decltype(*std::declval<It>())>::type>::type>::value>{};
+
+/**
+  @brief Serialization of whole objects by write_object and read_object. Defined in
+  bin_object.h.
+*/
+template<class T, class Enable = void>
+struct BinCodec;
+
+/**
+  @brief Base class of the binary writers.
+  
+  Implements the write functions on top of two functions of Derived:
+  
+  char* _prepare(uintptr_t len) makes room for len contiguous bytes at the current
+  position and returns a pointer to them.
+  
+  void _advance(uintptr_t len) moves the current position past len bytes filled in
+  after a call to _prepare.
+  
+  uintptr_t tell() returns the current position.
+  
+  Derived may also define void _writeBytes(const void* data, uintptr_t len), which
+  all writes of contiguous memory go through, and char* _skip(uintptr_t len), which
+  padding and element by element copies claim their room through. A _skip that
+  returns nullptr only moves the position and the bytes are not filled in.
+  
+  @param Derived The writer class.
 */
-class BinSerializer
+template<class Derived>
+class BinWriter
 {
-  uintptr_t _capacity = 0;
-  uintptr_t _size;
-  std::unique_ptr<char> _data;
-  char* _reader = 0;
+  Derived& _self()
+  {
+    return *static_cast<Derived*>(this);
+  }
   
-  void _reserve()
+  //makes room for len bytes at the position indicator, moves the position indicator
+  //past them and returns a pointer to them
+  char* _claim(uintptr_t len)
   {
-    if(_capacity == 0)
-      reserve(16);
-    else reserve(_capacity * 2);
+    char* ret = _self()._prepare(len);
+    _self()._advance(len);
+    return ret;
   }
   
-  void _reserveToNewSize(uintptr_t new_size)
+  //copies len bytes to the position indicator. Writers that can take large blocks
+  //of memory more cheaply than through _prepare define their own
+  void _writeBytes(const void* data, uintptr_t len)
   {
-    uintptr_t new_cap;
-    if(_capacity == 0)
-      new_cap = new_size;
-    else
+    memcpy(_claim(len), data, len);
+  }
+  
+  //claims len bytes for the caller to fill in. Writers that do not keep the data
+  //define their own that only moves the position and returns nullptr
+  char* _skip(uintptr_t len)
+  {
+    return _claim(len);
+  }
+  
+  template<class It>
+  void _writeN(It it, uintptr_t len, std::true_type)
+  {
+    typedef typename std::remove_reference<decltype(*it)>::type ValType;
+    _self()._writeBytes((const void*)&(*it), len * sizeof(ValType));
+  }
+  template<class It>
+  void _writeN(It it, uintptr_t len, std::false_type)
+  {
+    typedef typename std::remove_reference<decltype(*it)>::type ValType;
+    char* dest = _self()._skip(len * sizeof(ValType));
+    if(dest == nullptr)
+      return;
+    for(uintptr_t i = 0; i < len; ++i)
     {
-      new_cap = _capacity << 1;
-      while(new_cap < new_size)
-        new_cap <<= 1;
+      memcpy(dest, (const void*)&(*it), sizeof(ValType));
+      dest += sizeof(ValType);
+      ++it;
     }
-    reserve(new_cap);
+  }
+  
+  template<class T>
+  void _writeSorted(const T* data, uintptr_t len, size_t (*encode)(const T*, T*, uint8_t*))
+  {
+    T prev[4] = {0, 0, 0, 0};
+    uintptr_t i = 0;
+    for(; i + bin_for_block <= len; i += bin_for_block)
+      _self()._advance(encode(data + i, prev, (uint8_t*)_self()._prepare(bin_for_max_size)));
+    for(; i < len; ++i)
+    {
+      write_varint(uint64_t(T(data[i] - prev[i & 3])));
+      prev[i & 3] = data[i];
+    }
+  }
+  
+  template<class T>
+  void _writeOrdered(const T* data, uintptr_t len, bool big)
+  {
+    static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value,
+      "only numbers can be written in a fixed byte order");
+    static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8,
+      "only 1, 2, 4 and 8 byte numbers can be written in a fixed byte order");
+    if(big == bin_big_endian_host || sizeof(T) == 1)
+    {
+      write_span(data, len);
+      return;
+    }
+    const uintptr_t chunk = 4096 / sizeof(T);
+    for(uintptr_t i = 0; i < len; i += chunk)
+    {
+      uintptr_t n = len - i < chunk? len - i : chunk;
+      bin_byteswap(data + i, _self()._prepare(n * sizeof(T)), n, sizeof(T));
+      _self()._advance(n * sizeof(T));
+    }
+  }
+  
+  template<class It>
+  void _writeRange(It it1, It it2, std::true_type)
+  {
+    if(it2 - it1 > 0)
+      write(it1, int(it2 - it1));
+  }
+  template<class It>
+  void _writeRange(It it1, It it2, std::false_type)
+  {
+    for(; it1 != it2; ++it1)
+      write(*it1);
   }
 
 public:
   /**
-    @brief Constructor
-    @param size Initial capacity of the binary buffer. Capacity will grow by a factor
-    of two whenever the data outgrows the capacity.
+    @brief Writes a C-style string to the buffer.
+    @param str The string to write.
+    @return A reference to the object called.
   */
-  BinSerializer(int size = 1024):
-    _capacity(size),
-    _size(0),
-    _data(new char[size]),
-    _reader(_data.get())
-    {}
-  BinSerializer(const BinSerializer& other)
+  Derived& write(const char* str)
   {
-    _capacity = other._capacity;
-    _size = other._size;
-    _data.reset(new char[_capacity]);
-    memcpy(_data.get(), other._data.get(), _size);
-    _reader = _data.get() + (other._reader - other._data.get());
+    _self()._writeBytes(str, strlen(str));
+    
+    return _self();
   }
-  BinSerializer(BinSerializer&&) = default;
   
-  BinSerializer& operator=(const BinSerializer& other)
+  /**
+    @brief Writes binary data into the buffer.
+    @param obj Object to serialize.
+    @return A reference to the object called.
+  */
+  template<class T>
+  Derived& write(T&& obj)
   {
-    _capacity = other._capacity;
-    _size = other._size;
-    _data.reset(new char[_capacity]);
-    memcpy(_data.get(), other._data.get(), _size);
-    _reader = _data.get() + (other._reader - other._data.get());
-    return *this;
+    _self()._writeBytes((const void*)&obj, sizeof(T));
+    
+    return _self();
   }
-  BinSerializer& operator=(BinSerializer&&) = default;
   
   /**
-    @brief Reserves more memory for the buffer.
-    @param capacity Requested capacity in bytes. If lower than current capacity this
-    function does nothing.
+    @brief Writes a number of objects as binary data into the buffer.
+    
+    Objects from contiguous iterators (see bin_contiguous_iterator) of trivially
+    copyable types are copied with a single memcpy.
+    
+    @param it An iterator to the first object.
+    @param len Number of objects to write.
+    @return A reference to the object called.
   */
-  void reserve(uintptr_t capacity)
+  template<class T>
+  Derived& write(T it, int len)
   {
-    if(capacity < _capacity)
-      return;
+    typedef typename std::remove_reference<decltype(*it)>::type ValType;
+    typedef std::integral_constant<bool, bin_contiguous_iterator<T>::value
+      && std::is_trivially_copyable<ValType>::value> Contiguous;
     
-    std::unique_ptr<char> new_buffer(new char[capacity]);
-    memcpy(new_buffer.get(), _data.get(), _size);
-    _capacity = capacity;
-    _reader = new_buffer.get() + (_reader - _data.get());
-    _data = std::move(new_buffer);
+    if(len > 0)
+      _writeN(it, uintptr_t(len), Contiguous());
+    
+    return _self();
   }
   
   /**
-    @brief Gets a pointer to the buffer.
+    @brief Writes a range of objects as binary data into the buffer.
+    
+    The buffer is grown once for random access ranges, and contiguous ranges of
+    trivially copyable types are copied with a single memcpy.
+    
+    @param it1 Iterator to the first element in the range.
+    @param it2 Iterator past the end of the range.
+    @return A reference to the object called.
   */
-  char* get()
+  template<class T>
+  Derived& write(T it1, T it2)
   {
-    return _data.get();
+    typedef typename std::iterator_traits<T>::iterator_category Category;
+    _writeRange(it1, it2, std::is_base_of<std::random_access_iterator_tag, Category>());
+    
+    return _self();
   }
   
   /**
-    @brief Releases the ownership of the buffer and returns a pointer to it.
+    @brief Writes an array of objects as binary data into the buffer.
+    @param data Pointer to the first object.
+    @param len Number of objects to write.
+    @return A reference to the object called.
   */
-  char* steal()
+  template<class T>
+  Derived& write_span(const T* data, uintptr_t len)
   {
-    char* data = _data.release();
-    _capacity = 0;
-    _size = 0;
-    return data;
+    if(len > 0)
+      _writeN(data, len, std::true_type());
+    
+    return _self();
   }
   
   /**
-    @brief Moves the position indicator. Works like fseek in the C standard library.
-    @param offset in bytes to move the position indicator. Positive to move forward,
-    negative to move backward.
-    @param whence The position in the buffer to which the offset is relative to. Valid
-    values are SEEK_SET, SEEK_CUR, SEEK_END. If not a valid value this function does
-    nothing.
+    @brief Writes the elements of a vector as binary data into the buffer. No length is
+    written.
+    @param vec The vector to write.
     @return A reference to the object called.
   */
-  BinSerializer& seek(intptr_t offset, int whence)
+  template<class T, class A>
+  Derived& write_vector(const std::vector<T, A>& vec)
   {
-    switch(whence)
-    {
-    case SEEK_CUR:
-      break;
-    case SEEK_SET:
-      _reader = _data.get();;
-      break;
-    case SEEK_END:
-      _reader = _data.get() + _size;
-      break;
-    default:
-      return *this;
-    }
-    
-    _reader += offset;
-    if((uintptr_t)_reader < (uintptr_t)_data.get())
-      _reader = _data.get();
-    else if((uintptr_t)_reader > (uintptr_t)_data.get() + _size)
-      _reader = _data.get() + _size;
+    return write_span(vec.data(), vec.size());
+  }
+  
+  /**
+    @brief Writes an unsigned integer as a LEB128 varint, using one byte per 7 bits.
+    @param value The integer to write.
+    @return A reference to the object called.
+  */
+  Derived& write_varint(uint64_t value)
+  {
+    _self()._advance(bin_varint_encode(value, (uint8_t*)_self()._prepare(bin_varint_max_size)));
     
-    return *this;
+    return _self();
   }
   
   /**
-    @brief Returns the position indicator in bytes from the beginning of the buffer.
+    @brief Writes a signed integer as a zigzag encoded varint, so that small negative
+    values are as short as small positive ones.
+    @param value The integer to write.
+    @return A reference to the object called.
   */
-  uintptr_t tell()
+  Derived& write_zigzag(int64_t value)
   {
-    return uintptr_t(_reader - _data.get());
+    return write_varint(bin_zigzag_encode(value));
   }
   
   /**
-    @brief Writes a C-style string to the buffer.
-    @param str The string to write.
+    @brief Writes a number in little endian byte order.
+    @param value The integer, floating point number or enum to write.
     @return A reference to the object called.
   */
-  BinSerializer& write(const char* str)
+  template<class T>
+  Derived& write_le(T value)
   {
-    int len = strlen(str);
-    if((uintptr_t)((_reader - _data.get()) + len) > _size)
-    {
-      uintptr_t new_size = (_reader - _data.get()) + len;
-
-      if(new_size > _capacity)
-        _reserveToNewSize(new_size);
-      
-      _size = new_size;
-    }
+    _writeOrdered(&value, 1, false);
     
-    memcpy(_reader, str, len);
-    _reader += len;
+    return _self();
+  }
+  
+  /**
+    @brief Writes a number in big endian byte order.
+    @param value The integer, floating point number or enum to write.
+    @return A reference to the object called.
+  */
+  template<class T>
+  Derived& write_be(T value)
+  {
+    _writeOrdered(&value, 1, true);
     
-    return *this;
+    return _self();
   }
   
   /**
-    @brief Writes binary data into the buffer.
-    @param obj Object to serialize.
+    @brief Writes an array of numbers in little endian byte order. No length is
+    written. On little endian hosts this is write_span, otherwise the bytes are
+    swapped in bulk with SIMD shuffles where available.
+    @param data Pointer to the first number.
+    @param len Number of numbers to write.
     @return A reference to the object called.
   */
   template<class T>
-  BinSerializer& write(T&& obj)
+  Derived& write_le_span(const T* data, uintptr_t len)
   {
-    const uintptr_t fin_len = (_reader - _data.get()) + sizeof(T);
-    if(fin_len > _size)
-    {
-      uintptr_t new_size = fin_len;
-      if(new_size > _capacity)
-        _reserveToNewSize(new_size);
-      _size = new_size;
-    }
-    memcpy(_reader, (void*)&obj, sizeof(T));
-    _reader += sizeof(T);
+    _writeOrdered(data, len, false);
     
-    return *this;
+    return _self();
   }
   
   /**
-    @brief Writes a number of objects as binary data into the buffer.
-    @param it An iterator to the first object.
-    @param len Number of objects to write.
+    @brief Writes an array of numbers in big endian byte order. See write_le_span.
+    @param data Pointer to the first number.
+    @param len Number of numbers to write.
     @return A reference to the object called.
   */
   template<class T>
-  BinSerializer& write(T it, int len)
+  Derived& write_be_span(const T* data, uintptr_t len)
   {
-    using ValType = decltype(*it);
-    const uintptr_t fin_len = (_reader - _data.get()) + len * sizeof(ValType);
-    if(fin_len > _size)
-    {
-      uintptr_t new_size = fin_len;
-      
-      if(new_size > _capacity)
-      {
-        _reserveToNewSize(new_size);
-      }
-      
-      _size = new_size;
-    }
+    _writeOrdered(data, len, true);
     
-    for(int i = 0; i < len; ++i)
+    return _self();
+  }
+  
+  /**
+    @brief Writes an array of integers in stream vbyte encoding, using one to four
+    bytes per integer plus two bits of length. No length is written.
+    @param data Pointer to the first integer.
+    @param len Number of integers to write.
+    @return A reference to the object called.
+  */
+  Derived& write_varints(const uint32_t* data, uintptr_t len)
+  {
+    for(uintptr_t i = 0; i < len; i += bin_svb_chunk)
     {
-      memcpy(_reader, (void*)&(*it), sizeof(ValType));
-      _reader += sizeof(ValType);
-      ++it;
+      uintptr_t n = len - i < bin_svb_chunk? len - i : bin_svb_chunk;
+      uint8_t* out = (uint8_t*)_self()._prepare(bin_svb_max_size(n));
+      _self()._advance(bin_svb_encode(data + i, n, out));
     }
     
-    return *this;
+    return _self();
   }
   
   /**
-    @brief Writes a range of objects as binary data into the buffer.
-    @param it1 Iterator to the first element in the range.
-    @param it2 Iterator past the end of the range.
+    @brief Writes a sorted array of integers delta and frame of reference encoded.
+    
+    The integers are bit-packed in blocks of 128, using as many bits per integer as
+    the largest difference between neighbours in the block needs. The array does not
+    have to be sorted, but unsorted arrays do not compress. No length is written.
+    
+    @param data Pointer to the first integer.
+    @param len Number of integers to write.
     @return A reference to the object called.
   */
-  template<class T>
-  BinSerializer& write(const T it1, const T it2)
+  Derived& write_sorted_u32(const uint32_t* data, uintptr_t len)
+  {
+    _writeSorted(data, len, bin_for_encode32);
+    
+    return _self();
+  }
+  
+  /**
+    @brief Writes a sorted array of 64 bit integers delta and frame of reference
+    encoded. See write_sorted_u32.
+    @param data Pointer to the first integer.
+    @param len Number of integers to write.
+    @return A reference to the object called.
+  */
+  Derived& write_sorted_u64(const uint64_t* data, uintptr_t len)
+  {
+    _writeSorted(data, len, bin_for_encode64);
+    
+    return _self();
+  }
+  
+  /**
+    @brief Pads the buffer with zero bytes until the position indicator is a multiple
+    of alignment.
+    
+    Use before writing an array that is to be accessed in place with
+    BinDeserializer::view.
+    
+    @param alignment Alignment in bytes. Must be a power of two.
+    @return A reference to the object called.
+  */
+  Derived& align(uintptr_t alignment)
   {
-    using ValType = decltype(*it1);
-    if(_capacity < sizeof(ValType))
-      reserve(sizeof(ValType) * 2);
+    uintptr_t pos = _self().tell();
+    uintptr_t padding = ((pos + alignment - 1) & ~(alignment - 1)) - pos;
+    char* dest = _self()._skip(padding);
+    if(dest != nullptr)
+      memset(dest, 0, padding);
     
-    uintptr_t fin_len = (_reader - _data.get());
+    return _self();
+  }
+  
+  /**
+    @brief Writes an object field by field, following containers and nested objects.
+    See bin_object.h, which has to be included to use this function.
+    @param obj The object to write.
+    @return A reference to the object called.
+  */
+  template<class T>
+  Derived& write_object(const T& obj)
+  {
+    BinCodec<T>::write(_self(), obj);
     
-    while(it1 != it2)
+    return _self();
+  }
+};
+
+/**
+  @brief Pool of buffers for BinSerializer, in buckets of power of two sizes.
+  
+  Buffers given back to the pool are kept for the next serializer asking for one of
+  the same bucket, so serializing message after message stops allocating once the
+  pool has warmed up. A pool is not thread safe; local() returns one per thread.
+*/
+class BinBufferPool
+{
+  static const unsigned _buckets = sizeof(uintptr_t) * 8;
+  
+  std::vector<char*> _free[_buckets];
+  size_t _max_buffers;
+  uintptr_t _max_size;
+  
+  static unsigned _bucket(uintptr_t size)
+  {
+    unsigned b = 6;
+    while(b + 1 < _buckets && (uintptr_t(1) << b) < size)
+      ++b;
+    return b;
+  }
+  
+public:
+  /**
+    @brief Constructor
+    @param max_buffers Most buffers kept per bucket. default: 8
+    @param max_size Largest buffer size kept. Larger buffers are freed when they are
+    released. default: 16 MiB
+  */
+  explicit BinBufferPool(size_t max_buffers = 8, uintptr_t max_size = uintptr_t(16) << 20):
+    _max_buffers(max_buffers),
+    _max_size(max_size)
+    {}
+  BinBufferPool(const BinBufferPool&) = delete;
+  void operator=(const BinBufferPool&) = delete;
+  ~BinBufferPool()
+  {
+    clear();
+  }
+  
+  /**
+    @brief Returns the pool of the calling thread.
+  */
+  static BinBufferPool& local()
+  {
+    static thread_local BinBufferPool pool;
+    return pool;
+  }
+  
+  /**
+    @brief Takes a buffer from the pool, or allocates one if the bucket is empty.
+    @param size The size needed. Set to the size of the buffer returned, which is
+    the size rounded up to a power of two of at least 64.
+    @return The buffer, allocated with new[].
+  */
+  char* acquire(uintptr_t& size)
+  {
+    unsigned b = _bucket(size);
+    size = uintptr_t(1) << b;
+    if(_free[b].empty())
+      return new char[size];
+    char* ret = _free[b].back();
+    _free[b].pop_back();
+    return ret;
+  }
+  
+  /**
+    @brief Gives a buffer back to the pool.
+    @param data A buffer from acquire.
+    @param size The size acquire returned for it.
+  */
+  void release(char* data, uintptr_t size)
+  {
+    if(data == nullptr)
+      return;
+    unsigned b = _bucket(size);
+    if((uintptr_t(1) << b) != size || size > _max_size || _free[b].size() >= _max_buffers)
     {
-      fin_len += sizeof(ValType);
-      if(fin_len > _capacity)
-        _reserve();
-      memcpy(_reader, (void*)&(*it1), sizeof(ValType));
-      _reader += sizeof(ValType);
-      ++it1;
+      delete[] data;
+      return;
     }
-    
-    if(fin_len > _size)
-      _size = fin_len;
-      
-    return *this;
+    _free[b].push_back(data);
   }
+  
+  /**
+    @brief Frees all buffers in the pool.
+  */
+  void clear()
+  {
+    for(std::vector<char*>& bucket: _free)
+    {
+      for(char* data: bucket)
+        delete[] data;
+      bucket.clear();
+    }
+  }
+};
+
+/**
+  @brief Class for serializing binary data.
+  
+  The buffer is allocated with new[] by default. It can also come from a
+  BinBufferPool, which it is given back to when the serializer is destroyed, or be
+  memory of the caller, which is used until the data outgrows it. reset() empties
+  the serializer without freeing its buffer.
+*/
+class BinSerializer: public BinWriter<BinSerializer>
+{
+  friend class BinWriter<BinSerializer>;
+  
+  uintptr_t _capacity = 0;
+  uintptr_t _size = 0;
+  char* _data = nullptr;
+  char* _reader = nullptr;
+  BinBufferPool* _pool = nullptr;
+  bool _external = false;
+  
+  //allocates a buffer of at least capacity bytes, setting capacity to its size
+  char* _allocate(uintptr_t& capacity)
+  {
+    if(_pool != nullptr)
+      return _pool->acquire(capacity);
+    return new char[capacity];
+  }
+  
+  void _free()
+  {
+    if(_external)
+      _external = false;
+    else if(_pool != nullptr)
+      _pool->release(_data, _capacity);
+    else delete[] _data;
+    _data = nullptr;
+  }
+  
+  void _copy(const BinSerializer& other)
+  {
+    _capacity = other._capacity;
+    _size = other._size;
+    _data = _allocate(_capacity);
+    memcpy(_data, other._data, _size);
+    _reader = _data + (other._reader - other._data);
+  }
+  
+  void _move(BinSerializer& other)
+  {
+    _capacity = other._capacity;
+    _size = other._size;
+    _data = other._data;
+    _reader = other._reader;
+    _pool = other._pool;
+    _external = other._external;
+    other._capacity = 0;
+    other._size = 0;
+    other._data = nullptr;
+    other._reader = nullptr;
+    other._external = false;
+  }
+  
+  void _reserveToNewSize(uintptr_t new_size)
+  {
+    uintptr_t new_cap;
+    if(_capacity == 0)
+      new_cap = new_size;
+    else
+    {
+      new_cap = _capacity << 1;
+      while(new_cap < new_size)
+        new_cap <<= 1;
+    }
+    reserve(new_cap);
+  }
+  
+  //makes room for len bytes at the position indicator and returns a pointer to them
+  char* _prepare(uintptr_t len)
+  {
+    const uintptr_t fin_len = (_reader - _data) + len;
+    if(fin_len > _capacity)
+      _reserveToNewSize(fin_len);
+    return _reader;
+  }
+  
+  //moves the position indicator past len bytes filled in after _prepare
+  void _advance(uintptr_t len)
+  {
+    _reader += len;
+    if((uintptr_t)(_reader - _data) > _size)
+      _size = _reader - _data;
+  }
+  
+public:
+  /**
+    @brief Constructor
+    @param size Initial capacity of the binary buffer. Capacity will grow by a factor
+    of two whenever the data outgrows the capacity.
+  */
+  BinSerializer(int size = 1024):
+    _capacity(size),
+    _data(new char[size]),
+    _reader(_data)
+    {}
+  /**
+    @brief Constructor. Writes into memory of the caller, which must outlive the
+    object, until the data outgrows it. The data is then moved to a buffer of its own.
+    @param buffer The memory to write into.
+    @param capacity Size of the memory in bytes.
+  */
+  BinSerializer(char* buffer, uintptr_t capacity):
+    _capacity(capacity),
+    _data(buffer),
+    _reader(buffer),
+    _external(true)
+    {}
+  /**
+    @brief Constructor. Takes its buffers from a pool and gives them back when they
+    are outgrown or the object is destroyed.
+    @param pool The pool, which must outlive the object. BinBufferPool::local() for
+    the pool of the thread.
+    @param size Initial capacity of the binary buffer, rounded up to a power of two.
+  */
+  explicit BinSerializer(BinBufferPool& pool, uintptr_t size = 1024):
+    _capacity(size),
+    _pool(&pool)
+  {
+    _data = _allocate(_capacity);
+    _reader = _data;
+  }
+  BinSerializer(const BinSerializer& other):
+    _pool(other._pool)
+  {
+    _copy(other);
+  }
+  BinSerializer(BinSerializer&& other)
+  {
+    _move(other);
+  }
+  ~BinSerializer()
+  {
+    _free();
+  }
+  
+  BinSerializer& operator=(const BinSerializer& other)
+  {
+    if(this != &other)
+    {
+      _free();
+      _pool = other._pool;
+      _copy(other);
+    }
+    return *this;
+  }
+  BinSerializer& operator=(BinSerializer&& other)
+  {
+    if(this != &other)
+    {
+      _free();
+      _move(other);
+    }
+    return *this;
+  }
+  
+  /**
+    @brief Reserves more memory for the buffer.
+    @param capacity Requested capacity in bytes. If lower than current capacity this
+    function does nothing. BinSizeCounter::capacity gives the capacity data needs.
+  */
+  void reserve(uintptr_t capacity)
+  {
+    if(capacity < _capacity)
+      return;
+    
+    char* new_buffer = _allocate(capacity);
+    if(_size != 0)
+      memcpy(new_buffer, _data, _size);
+    uintptr_t pos = _reader - _data;
+    _free();
+    _capacity = capacity;
+    _data = new_buffer;
+    _reader = new_buffer + pos;
+  }
+  
+  /**
+    @brief Empties the serializer, keeping its buffer for the next data.
+  */
+  void reset()
+  {
+    _size = 0;
+    _reader = _data;
+  }
+  
+  /**
+    @brief Returns the capacity of the buffer in bytes.
+  */
+  uintptr_t capacity() const
+  {
+    return _capacity;
+  }
+  
+  /**
+    @brief Returns the number of bytes written to the buffer.
+  */
+  uintptr_t size() const
+  {
+    return _size;
+  }
+  
+  /**
+    @brief Gets a pointer to the buffer.
+  */
+  char* get()
+  {
+    return _data;
+  }
+  
+  /**
+    @brief Releases the ownership of the buffer and returns a pointer to it. The
+    buffer is allocated with new[]. If it is memory of the caller, the data is first
+    copied into one that is.
+  */
+  char* steal()
+  {
+    char* data = _data;
+    if(_external)
+    {
+      data = new char[_size? _size : 1];
+      memcpy(data, _data, _size);
+      _external = false;
+    }
+    _data = nullptr;
+    _capacity = 0;
+    _size = 0;
+    _reader = nullptr;
+    return data;
+  }
+  
+  /**
+    @brief Moves the position indicator. Works like fseek in the C standard library.
+    @param offset in bytes to move the position indicator. Positive to move forward,
+    negative to move backward.
+    @param whence The position in the buffer to which the offset is relative to. Valid
+    values are SEEK_SET, SEEK_CUR, SEEK_END. If not a valid value this function does
+    nothing.
+    @return A reference to the object called.
+  */
+  BinSerializer& seek(intptr_t offset, int whence)
+  {
+    switch(whence)
+    {
+    case SEEK_CUR:
+      break;
+    case SEEK_SET:
+      _reader = _data;
+      break;
+    case SEEK_END:
+      _reader = _data + _size;
+      break;
+    default:
+      return *this;
+    }
+    
+    _reader += offset;
+    if((uintptr_t)_reader < (uintptr_t)_data)
+      _reader = _data;
+    else if((uintptr_t)_reader > (uintptr_t)_data + _size)
+      _reader = _data + _size;
+    
+    return *this;
+  }
+  
+  /**
+    @brief Returns the position indicator in bytes from the beginning of the buffer.
+  */
+  uintptr_t tell()
+  {
+    return uintptr_t(_reader - _data);
+  }
+  
+};
+
+/**
+  @brief Writer that only counts the bytes written to it.
+  
+  Running the serialization code through a BinSizeCounter first gives the exact size
+  of the data, so that the real writer can be reserved once and never regrows.
+  Contiguous writes, element by element copies and padding only add their size, which
+  folds to a constant for types of fixed size. Encoded integers are encoded into a
+  scratch buffer to measure them.
+*/
+class BinSizeCounter: public BinWriter<BinSizeCounter>
+{
+  friend class BinWriter<BinSizeCounter>;
+  
+  uintptr_t _pos;
+  uintptr_t _peak;
+  std::unique_ptr<char[]> _scratch;
+  uintptr_t _capacity = 0;
+  
+  char* _prepare(uintptr_t len)
+  {
+    if(_pos + len > _peak)
+      _peak = _pos + len;
+    if(len > _capacity)
+    {
+      uintptr_t new_cap = _capacity? _capacity : 256;
+      while(new_cap < len)
+        new_cap <<= 1;
+      _scratch.reset(new char[new_cap]);
+      _capacity = new_cap;
+    }
+    return _scratch.get();
+  }
+  
+  void _advance(uintptr_t len)
+  {
+    _pos += len;
+  }
+  
+  void _writeBytes(const void*, uintptr_t len)
+  {
+    _pos += len;
+    if(_pos > _peak)
+      _peak = _pos;
+  }
+  
+  char* _skip(uintptr_t len)
+  {
+    _writeBytes(nullptr, len);
+    return nullptr;
+  }
+  
+public:
+  /**
+    @brief Constructor
+    @param start Position the data is going to be written at in the real writer,
+    for align() to pad the same. default: 0
+  */
+  explicit BinSizeCounter(uintptr_t start = 0):
+    _pos(start),
+    _peak(start)
+    {}
+  
+  /**
+    @brief Returns the position the real writer would be at, that is the start
+    position plus the number of bytes counted.
+  */
+  uintptr_t tell() const
+  {
+    return _pos;
+  }
+  
+  /**
+    @brief Returns the capacity the real writer needs to write the data without
+    growing. Encoders ask for room for their worst case, so this can be a few bytes
+    more than tell().
+  */
+  uintptr_t capacity() const
+  {
+    return _peak;
+  }
+};
+
+/**
+  @brief Returns the number of bytes write_object writes for an object. See
+  BinSizeCounter.
+*/
+template<class T>
+uintptr_t bin_object_size(const T& obj)
+{
+  return BinSizeCounter().write_object(obj).tell();
+}
+
+/**
+  @brief Append-only serializer that stores its data in a chain of fixed-size blocks.
+  
+  Growing never moves data already written, so serializing n bytes costs O(n) and
+  never holds two copies of the data. Writes that do not fit in the rest of the
+  current block start a new block, so every write is contiguous and the end of a
+  block may be left unused. The data can be handed to writev() as an iovec list, or
+  flattened into one contiguous buffer.
+*/
+class SegmentedBinSerializer: public BinWriter<SegmentedBinSerializer>
+{
+  friend class BinWriter<SegmentedBinSerializer>;
+  
+  struct __Segment
+  {
+    std::unique_ptr<char[]> data;
+    uintptr_t size;
+    uintptr_t capacity;
+    
+    __Segment(uintptr_t cap): data(new char[cap]), size(0), capacity(cap){}
+  };
+  
+  std::vector<__Segment> _segments;
+  uintptr_t _block_size;
+  uintptr_t _size = 0;
+  
+  char* _prepare(uintptr_t len)
+  {
+    if(_segments.empty() || _segments.back().capacity - _segments.back().size < len)
+      _segments.emplace_back(len > _block_size? len : _block_size);
+    return _segments.back().data.get() + _segments.back().size;
+  }
+  
+  void _advance(uintptr_t len)
+  {
+    _segments.back().size += len;
+    _size += len;
+  }
+  
+public:
+  /**
+    @brief Constructor
+    @param block_size Size in bytes of the blocks. Writes larger than this get a block
+    of their own. default: 64 KiB
+  */
+  SegmentedBinSerializer(uintptr_t block_size = uintptr_t(64) << 10):
+    _block_size(block_size? block_size : 1)
+    {}
+  
+  /**
+    @brief Returns the number of bytes written.
+  */
+  uintptr_t size() const
+  {
+    return _size;
+  }
+  
+  /**
+    @brief Returns the position indicator, which is always at the end of the data.
+  */
+  uintptr_t tell() const
+  {
+    return _size;
+  }
+  
+  /**
+    @brief Returns the number of blocks.
+  */
+  size_t segments() const
+  {
+    return _segments.size();
+  }
+  
+  /**
+    @brief Calls f(const char* data, uintptr_t size) for every block in order.
+  */
+  template<class F>
+  void for_each_segment(F f) const
+  {
+    for(const __Segment& seg: _segments)
+      if(seg.size)
+        f((const char*)seg.data.get(), seg.size);
+  }
+  
+#if defined(__unix__) || defined(__APPLE__)
+  /**
+    @brief Returns the blocks as an iovec list for writev().
+    @note writev() accepts at most IOV_MAX entries per call.
+  */
+  std::vector<struct iovec> iovecs() const
+  {
+    std::vector<struct iovec> ret;
+    ret.reserve(_segments.size());
+    for_each_segment([&ret](const char* data, uintptr_t size)
+    {
+      struct iovec v;
+      v.iov_base = (void*)data;
+      v.iov_len = size;
+      ret.push_back(v);
+    });
+    return ret;
+  }
+#endif
+  
+  /**
+    @brief Copies the data into dest, which must have room for size() bytes.
+  */
+  void copy_to(char* dest) const
+  {
+    for_each_segment([&dest](const char* data, uintptr_t size)
+    {
+      memcpy(dest, data, size);
+      dest += size;
+    });
+  }
+  
+  /**
+    @brief Returns the data copied into a BinSerializer with the position indicator at
+    the end.
+  */
+  BinSerializer flatten() const
+  {
+    BinSerializer ret(0);
+    ret.reserve(_size);
+    for_each_segment([&ret](const char* data, uintptr_t size)
+    {
+      ret.write_span(data, size);
+    });
+    return ret;
+  }
+  
+  /**
+    @brief Discards the data, keeping the first block for reuse.
+  */
+  void clear()
+  {
+    if(_segments.size() > 1)
+      _segments.erase(_segments.begin() + 1, _segments.end());
+    if(!_segments.empty())
+      _segments.front().size = 0;
+    _size = 0;
+  }
+};
+
+/**
+  @brief A bounds-checked view of an array of objects inside a buffer.
+  @param T value type.
+*/
+template<class T>
+class BinView
+{
+  const T* _data;
+  size_t _size;
+  
+public:
+  BinView(): _data(nullptr), _size(0){}
+  BinView(const T* data, size_t size): _data(data), _size(size){}
+  
+  const T* data() const {return _data;}
+  size_t size() const {return _size;}
+  bool empty() const {return _size == 0;}
+  
+  const T& operator[](size_t idx) const {return _data[idx];}
+  const T* begin() const {return _data;}
+  const T* end() const {return _data + _size;}
+};
+
+/**
+  @brief Base class of the binary readers.
+  
+  Implements the decoding read functions on top of three functions of Derived:
+  
+  uintptr_t _fill(uintptr_t len) makes up to len bytes available at the current
+  position and returns how many contiguous bytes are available there, which is less
+  than len only at the end of the data.
+  
+  const char* _cursor() returns a pointer to the current position.
+  
+  void _consume(uintptr_t len) moves the current position past len available bytes.
+  
+  uintptr_t tell() returns the current position.
+  
+  Derived may also define bool _mayContain(uintptr_t len), returning false if the
+  data is known to end before len more bytes.
+  
+  @param Derived The reader class.
+*/
+template<class Derived>
+class BinReader
+{
+  Derived& _self()
+  {
+    return *static_cast<Derived*>(this);
+  }
+  
+  template<class T>
+  bool _readSorted(T* out, uintptr_t len,
+    size_t (*decode)(const uint8_t*, size_t, T*, T*))
+  {
+    T prev[4] = {0, 0, 0, 0};
+    uintptr_t i = 0;
+    for(; i + bin_for_block <= len; i += bin_for_block)
+    {
+      uintptr_t avail = _self()._fill(bin_for_max_size);
+      size_t used = decode((const uint8_t*)_self()._cursor(), avail, prev, out + i);
+      if(used == 0)
+      {
+        _good = false;
+        return false;
+      }
+      _self()._consume(used);
+    }
+    for(; i < len; ++i)
+    {
+      prev[i & 3] += T(read_varint());
+      out[i] = prev[i & 3];
+    }
+    return _good;
+  }
+  
+  template<class T>
+  bool _readOrdered(T* out, uintptr_t len, bool big)
+  {
+    static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value,
+      "only numbers can be read in a fixed byte order");
+    static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8,
+      "only 1, 2, 4 and 8 byte numbers can be read in a fixed byte order");
+    bool swap = big != bin_big_endian_host && sizeof(T) > 1;
+    char* dest = (char*)out;
+    uintptr_t left = len * sizeof(T);
+    if(len > uintptr_t(-1) / sizeof(T) || !_self()._mayContain(left))
+    {
+      _good = false;
+      return false;
+    }
+    while(left > 0)
+    {
+      uintptr_t n = _self()._fill(left < 4096? left : 4096) / sizeof(T) * sizeof(T);
+      if(n == 0)
+      {
+        _good = false;
+        return false;
+      }
+      if(n > left)
+        n = left;
+      if(swap)
+        bin_byteswap(_self()._cursor(), dest, n / sizeof(T), sizeof(T));
+      else memcpy(dest, _self()._cursor(), n);
+      _self()._consume(n);
+      dest += n;
+      left -= n;
+    }
+    return true;
+  }
+  
+  bool _mayContain(uintptr_t)
+  {
+    return true;
+  }
+  
+protected:
+  bool _good = true;
+  
+public:
+  /**
+    @brief Returns false if any read has failed.
+  */
+  bool good() const
+  {
+    return _good;
+  }
+  
+  /**
+    @brief Returns false if the data is known to end before len more bytes. Used to
+    reject corrupt lengths before allocating memory for them.
+  */
+  bool may_contain(uintptr_t len)
+  {
+    return _self()._mayContain(len);
+  }
+  
+  /**
+    @brief Reads an object.
+    @return The object read, or a value initialized object if there is not enough data
+    left.
+  */
+  template<class T>
+  T read()
+  {
+    static_assert(std::is_trivially_copyable<T>::value,
+      "BinReader can only read trivially copyable types");
+    T ret = T();
+    if(_self()._fill(sizeof(T)) < sizeof(T))
+      _good = false;
+    else
+    {
+      memcpy((void*)&ret, _self()._cursor(), sizeof(T));
+      _self()._consume(sizeof(T));
+    }
+    return ret;
+  }
+  
+  /**
+    @brief Reads a number written by BinSerializer::write_le.
+    @return The number, or 0 if there is not enough data left.
+  */
+  template<class T>
+  T read_le()
+  {
+    T ret = T();
+    _readOrdered(&ret, 1, false);
+    return ret;
+  }
+  
+  /**
+    @brief Reads a number written by BinSerializer::write_be.
+    @return The number, or 0 if there is not enough data left.
+  */
+  template<class T>
+  T read_be()
+  {
+    T ret = T();
+    _readOrdered(&ret, 1, true);
+    return ret;
+  }
+  
+  /**
+    @brief Reads an array of numbers written by BinSerializer::write_le_span.
+    @param out Where to store the numbers.
+    @param len Number of numbers to read.
+    @return false if there is not enough data left.
+  */
+  template<class T>
+  bool read_le(T* out, uintptr_t len)
+  {
+    return _readOrdered(out, len, false);
+  }
+  
+  /**
+    @brief Reads an array of numbers written by BinSerializer::write_be_span.
+    @param out Where to store the numbers.
+    @param len Number of numbers to read.
+    @return false if there is not enough data left.
+  */
+  template<class T>
+  bool read_be(T* out, uintptr_t len)
+  {
+    return _readOrdered(out, len, true);
+  }
+  
+  /**
+    @brief Reads an integer written by BinSerializer::write_varint.
+    @return The integer, or 0 if the data is truncated or malformed.
+  */
+  uint64_t read_varint()
+  {
+    uint64_t ret = 0;
+    uintptr_t avail = _self()._fill(bin_varint_max_size);
+    size_t len = bin_varint_decode((const uint8_t*)_self()._cursor(), avail, ret);
+    if(len == 0)
+    {
+      _good = false;
+      return 0;
+    }
+    _self()._consume(len);
+    return ret;
+  }
+  
+  /**
+    @brief Reads an integer written by BinSerializer::write_zigzag.
+    @return The integer, or 0 if the data is truncated or malformed.
+  */
+  int64_t read_zigzag()
+  {
+    return bin_zigzag_decode(read_varint());
+  }
+  
+  /**
+    @brief Reads an array of integers written by BinSerializer::write_varints.
+    @param out Where to store the integers.
+    @param len Number of integers to read.
+    @return false if the data is truncated.
+  */
+  bool read_varints(uint32_t* out, uintptr_t len)
+  {
+    for(uintptr_t i = 0; i < len; i += bin_svb_chunk)
+    {
+      uintptr_t n = len - i < bin_svb_chunk? len - i : bin_svb_chunk;
+      uintptr_t avail = _self()._fill(bin_svb_max_size(n));
+      size_t used = bin_svb_decode((const uint8_t*)_self()._cursor(), avail, out + i, n);
+      if(used == 0)
+      {
+        _good = false;
+        return false;
+      }
+      _self()._consume(used);
+    }
+    return true;
+  }
+  
+  /**
+    @brief Reads an array of integers written by BinSerializer::write_sorted_u32.
+    @param out Where to store the integers.
+    @param len Number of integers to read.
+    @return false if the data is truncated or malformed.
+  */
+  bool read_sorted_u32(uint32_t* out, uintptr_t len)
+  {
+    return _readSorted(out, len, bin_for_decode32);
+  }
+  
+  /**
+    @brief Reads an array of integers written by BinSerializer::write_sorted_u64.
+    @param out Where to store the integers.
+    @param len Number of integers to read.
+    @return false if the data is truncated or malformed.
+  */
+  bool read_sorted_u64(uint64_t* out, uintptr_t len)
+  {
+    return _readSorted(out, len, bin_for_decode64);
+  }
+  
+  /**
+    @brief Skips over padding written by BinSerializer::align.
+    @param alignment Alignment in bytes. Must be a power of two.
+    @return A reference to the object called.
+  */
+  Derived& align(uintptr_t alignment)
+  {
+    uintptr_t pos = _self().tell();
+    uintptr_t padding = ((pos + alignment - 1) & ~(alignment - 1)) - pos;
+    if(_self()._fill(padding) < padding)
+      _good = false;
+    else _self()._consume(padding);
+    return _self();
+  }
+  
+  /**
+    @brief Reads an object written by BinWriter::write_object. See bin_object.h, which
+    has to be included to use this function.
+    @param obj The object to read into.
+    @return false if the data is truncated or malformed.
+  */
+  template<class T>
+  bool read_object(T& obj)
+  {
+    if(!BinCodec<T>::read(_self(), obj))
+      _good = false;
+    return _good;
+  }
+};
+
+/**
+  @brief Class for reading binary data written by BinSerializer.
+  
+  Reads from either a buffer it owns or from foreign memory, such as a memory mapped
+  file or a received block. Reads past the end of the data do not touch memory outside
+  the buffer. They fail, leaving the position indicator where it was, and clear the
+  flag returned by good().
+*/
+class BinDeserializer: public BinReader<BinDeserializer>
+{
+  friend class BinReader<BinDeserializer>;
+  
+  std::unique_ptr<char[]> _owned;
+  const char* _data;
+  uintptr_t _size;
+  const char* _reader;
+  
+  uintptr_t _fill(uintptr_t)
+  {
+    return remaining();
+  }
+  const char* _cursor() const
+  {
+    return _reader;
+  }
+  void _consume(uintptr_t len)
+  {
+    _reader += len;
+  }
+  bool _mayContain(uintptr_t len)
+  {
+    return len <= remaining();
+  }
+  
+public:
+  using BinReader<BinDeserializer>::read;
+  
+  /**
+    @brief Constructor. Reads from foreign memory which must outlive the object.
+    @param data Pointer to the data.
+    @param size Size of the data in bytes.
+  */
+  BinDeserializer(const char* data, uintptr_t size):
+    _data(data),
+    _size(size),
+    _reader(data)
+    {}
+  /**
+    @brief Constructor. Takes ownership of a buffer.
+    @param data The buffer, allocated with new[].
+    @param size Size of the data in bytes.
+  */
+  BinDeserializer(std::unique_ptr<char[]> data, uintptr_t size):
+    _owned(std::move(data)),
+    _data(_owned.get()),
+    _size(size),
+    _reader(_data)
+    {}
+  /**
+    @brief Constructor. Reads the contents of a serializer without copying them. The
+    serializer must outlive the object and not be written to meanwhile.
+  */
+  explicit BinDeserializer(BinSerializer& serializer):
+    BinDeserializer(serializer.get(), serializer.size())
+    {}
+  /**
+    @brief Constructor. Takes over the buffer of a serializer.
+  */
+  explicit BinDeserializer(BinSerializer&& serializer):
+    _size(serializer.size())
+  {
+    _owned.reset(serializer.steal());
+    _data = _owned.get();
+    _reader = _data;
+  }
+  BinDeserializer(const BinDeserializer&) = delete;
+  BinDeserializer(BinDeserializer&&) = default;
+  BinDeserializer& operator=(const BinDeserializer&) = delete;
+  BinDeserializer& operator=(BinDeserializer&&) = default;
+  
+  /**
+    @brief Gets a pointer to the data.
+  */
+  const char* get() const
+  {
+    return _data;
+  }
+  
+  /**
+    @brief Returns the size of the data in bytes.
+  */
+  uintptr_t size() const
+  {
+    return _size;
+  }
+  
+  /**
+    @brief Returns the number of bytes left to read.
+  */
+  uintptr_t remaining() const
+  {
+    return uintptr_t(_data + _size - _reader);
+  }
+  
+  /**
+    @brief Moves the position indicator. Works like BinSerializer::seek.
+    @return A reference to the object called.
+  */
+  BinDeserializer& seek(intptr_t offset, int whence)
+  {
+    intptr_t pos;
+    switch(whence)
+    {
+    case SEEK_CUR:
+      pos = _reader - _data;
+      break;
+    case SEEK_SET:
+      pos = 0;
+      break;
+    case SEEK_END:
+      pos = _size;
+      break;
+    default:
+      return *this;
+    }
+    
+    pos += offset;
+    if(pos < 0)
+      pos = 0;
+    else if((uintptr_t)pos > _size)
+      pos = _size;
+    _reader = _data + pos;
+    
+    return *this;
+  }
+  
+  /**
+    @brief Returns the position indicator in bytes from the beginning of the data.
+  */
+  uintptr_t tell() const
+  {
+    return uintptr_t(_reader - _data);
+  }
+  
+  /**
+    @brief Reads a number of objects.
+    @param out Where to copy the objects.
+    @param len Number of objects to read.
+    @return false if there is not enough data left, in which case nothing is read.
+  */
+  template<class T>
+  bool read(T* out, uintptr_t len)
+  {
+    static_assert(std::is_trivially_copyable<T>::value,
+      "BinDeserializer can only read trivially copyable types");
+    if(len > remaining() / sizeof(T))
+    {
+      _good = false;
+      return false;
+    }
+    memcpy((void*)out, _reader, len * sizeof(T));
+    _reader += len * sizeof(T);
+    return true;
+  }
+  
+  /**
+    @brief Returns a view of a number of objects in the buffer, without copying them.
+    
+    The data must be suitably aligned for T, see BinSerializer::align. The view is
+    valid as long as the data is.
+    
+    @param len Number of objects.
+    @return A view of the objects, or an empty view if there is not enough data left or
+    the data is misaligned.
+  */
+  template<class T>
+  BinView<T> view(uintptr_t len)
+  {
+    static_assert(std::is_trivially_copyable<T>::value,
+      "BinDeserializer can only read trivially copyable types");
+    if(len > remaining() / sizeof(T) || (uintptr_t)_reader % alignof(T) != 0)
+    {
+      _good = false;
+      return BinView<T>();
+    }
+    BinView<T> ret((const T*)_reader, len);
+    _reader += len * sizeof(T);
+    return ret;
+  }
+  
 };
 
 #endif
\ No newline at end of file
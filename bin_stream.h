@@ -0,0 +1,495 @@
+#ifndef BIN_STREAM_H_INCLUDED
+#define BIN_STREAM_H_INCLUDED
+
+/**
+  @file
+  @author Erik Boström <cewbostrom@gmail.com>
+  @date 16.10.2026
+
+  @section LICENSE
+
+  MIT License (MIT)
+
+  Copyright (c) 2015 Erik Boström
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+
+  @section DESCRIPTION
+
+  Streaming counterparts of BinSerializer and BinDeserializer that write to and read
+  from a file descriptor through a fixed-size buffer, so that memory use does not
+  depend on the size of the data. POSIX only.
+
+  usage:
+
+  BinStreamWriter has the write functions of BinSerializer and flushes its buffer to
+  the file descriptor as it fills. Large arrays bypass the buffer. Call flush() when
+  done, or let the destructor do it. BinStreamReader has the read functions of
+  BinDeserializer and reads the file sequentially, hinting the kernel to read ahead.
+*/
+
+#include <memory>
+#include <new>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+#include "bin_serializer.h"
+
+/**
+  @brief Serializer that streams its data to a file descriptor.
+
+  Writes go into a staging buffer that is written out with write() whenever it fills.
+  Contiguous writes larger than the buffer are handed to writev() together with the
+  staged data instead of being copied. Writes that do not fit in the buffer grow it.
+
+  In direct mode the file descriptor is switched to O_DIRECT, the buffer is aligned to
+  4096 bytes and only whole aligned blocks are written, so the data bypasses the page
+  cache. The file offset of the descriptor must then be aligned too.
+  If the file system does not support O_DIRECT the writer silently falls back to
+  buffered I/O.
+*/
+class BinStreamWriter: public BinWriter<BinStreamWriter>
+{
+  friend class BinWriter<BinStreamWriter>;
+
+  int _fd;
+  char* _buffer = nullptr;
+  uintptr_t _capacity;
+  uintptr_t _used = 0;
+  uintptr_t _flushed = 0;
+  bool _direct = false;
+  bool _good = true;
+
+  static const uintptr_t _alignment = 4096;
+
+  static char* _allocate(uintptr_t size)
+  {
+    void* ret = nullptr;
+    if(posix_memalign(&ret, _alignment, size) != 0)
+      return nullptr;
+    return (char*)ret;
+  }
+
+  //writes the whole iovec list, retrying on partial writes and interrupts
+  bool _writeAll(struct iovec* iov, int count)
+  {
+    while(count > 0)
+    {
+      ssize_t n = ::writev(_fd, iov, count);
+      if(n < 0)
+      {
+        if(errno == EINTR)
+          continue;
+        if(errno == EINVAL && _direct)
+        {
+          //the file system turned out not to support direct I/O
+          _setDirect(false);
+          continue;
+        }
+        _good = false;
+        return false;
+      }
+      _flushed += n;
+      while(count > 0 && (uintptr_t)n >= iov->iov_len)
+      {
+        n -= iov->iov_len;
+        ++iov;
+        --count;
+      }
+      if(count > 0)
+      {
+        iov->iov_base = (char*)iov->iov_base + n;
+        iov->iov_len -= n;
+      }
+    }
+    return true;
+  }
+
+  //writes the first len bytes of the buffer. on failure the buffered data is dropped
+  //so that the buffer does not grow
+  bool _writeBuffer(uintptr_t len)
+  {
+    struct iovec iov;
+    iov.iov_base = _buffer;
+    iov.iov_len = len;
+    if(!_writeAll(&iov, 1))
+    {
+      _used = 0;
+      return false;
+    }
+    memmove(_buffer, _buffer + len, _used - len);
+    _used -= len;
+    return true;
+  }
+
+  //writes the staged data. in direct mode only whole blocks are written unless all is
+  //set, in which case direct I/O is turned off for the unaligned tail
+  bool _flush(bool all)
+  {
+    uintptr_t len = _direct? _used & ~(_alignment - 1) : _used;
+    if(len != 0 && !_writeBuffer(len))
+      return false;
+    if(all && _used != 0)
+    {
+      _setDirect(false);
+      return _writeBuffer(_used);
+    }
+    return true;
+  }
+
+  void _setDirect(bool direct)
+  {
+#ifdef O_DIRECT
+    int flags = fcntl(_fd, F_GETFL);
+    if(flags == -1)
+      direct = false;
+    else if(fcntl(_fd, F_SETFL, direct? flags | O_DIRECT : flags & ~O_DIRECT) == -1)
+      direct = false;
+#else
+    direct = false;
+#endif
+    _direct = direct;
+  }
+
+  char* _prepare(uintptr_t len)
+  {
+    if(_capacity - _used < len)
+    {
+      _flush(false);
+      if(_capacity - _used < len)
+      {
+        uintptr_t new_cap = _capacity << 1;
+        while(new_cap - _used < len)
+          new_cap <<= 1;
+        char* buffer = _allocate(new_cap);
+        if(buffer == nullptr)
+          throw std::bad_alloc();
+        memcpy(buffer, _buffer, _used);
+        free(_buffer);
+        _buffer = buffer;
+        _capacity = new_cap;
+      }
+    }
+    return _buffer + _used;
+  }
+
+  void _advance(uintptr_t len)
+  {
+    _used += len;
+  }
+
+  void _writeBytes(const void* data, uintptr_t len)
+  {
+    if(len <= _capacity - _used)
+    {
+      memcpy(_buffer + _used, data, len);
+      _used += len;
+      return;
+    }
+    if(_direct || len < _capacity)
+    {
+      //direct I/O needs aligned memory, so everything goes through the buffer
+      const char* src = (const char*)data;
+      while(len > 0)
+      {
+        if(_used == _capacity && !_flush(false))
+          return;
+        uintptr_t n = _capacity - _used < len? _capacity - _used : len;
+        memcpy(_buffer + _used, src, n);
+        _used += n;
+        src += n;
+        len -= n;
+      }
+      return;
+    }
+    struct iovec iov[2];
+    iov[0].iov_base = _buffer;
+    iov[0].iov_len = _used;
+    iov[1].iov_base = (void*)data;
+    iov[1].iov_len = len;
+    _writeAll(iov, 2);
+    _used = 0;
+  }
+
+public:
+  /**
+    @brief Constructor
+    @param fd File descriptor to write to. It is not closed by the writer.
+    @param buffer_size Size of the staging buffer in bytes. default: 1 MiB
+    @param direct Write with O_DIRECT. default: false
+  */
+  BinStreamWriter(int fd, uintptr_t buffer_size = uintptr_t(1) << 20, bool direct = false):
+    _fd(fd)
+  {
+    _capacity = (buffer_size + _alignment - 1) & ~(_alignment - 1);
+    if(_capacity < 4 * _alignment)
+      _capacity = 4 * _alignment;
+    _buffer = _allocate(_capacity);
+    if(_buffer == nullptr)
+      throw std::bad_alloc();
+    if(direct)
+      _setDirect(true);
+  }
+  BinStreamWriter(const BinStreamWriter&) = delete;
+  void operator=(const BinStreamWriter&) = delete;
+  ~BinStreamWriter()
+  {
+    flush();
+    free(_buffer);
+  }
+
+  /**
+    @brief Writes all buffered data to the file descriptor.
+
+    In direct mode a partial block at the end is written with direct I/O turned off,
+    and it stays off since the file offset is no longer aligned.
+
+    @return false if a write has failed.
+  */
+  bool flush()
+  {
+    return _good && _flush(true);
+  }
+
+  /**
+    @brief Returns the number of bytes written, including those still buffered.
+  */
+  uintptr_t tell() const
+  {
+    return _flushed + _used;
+  }
+  uintptr_t size() const
+  {
+    return tell();
+  }
+
+  /**
+    @brief Returns false if a write to the file descriptor has failed.
+  */
+  bool good() const
+  {
+    return _good;
+  }
+
+  /**
+    @brief Returns true if the writer is using direct I/O.
+  */
+  bool direct() const
+  {
+    return _direct;
+  }
+};
+
+/**
+  @brief Deserializer that streams its data from a file descriptor.
+
+  Data is read sequentially into a buffer, which only grows if a single read needs
+  more contiguous bytes than it holds. The kernel is told that the file is read
+  sequentially and asked to prefetch the data following the buffer. Reads of large
+  arrays go straight into the destination.
+*/
+class BinStreamReader: public BinReader<BinStreamReader>
+{
+  friend class BinReader<BinStreamReader>;
+
+  int _fd;
+  std::unique_ptr<char[]> _buffer;
+  uintptr_t _capacity;
+  uintptr_t _begin = 0;
+  uintptr_t _end = 0;
+  uintptr_t _consumed = 0;
+  off_t _file_pos;
+  uintptr_t _readahead;
+  bool _eof = false;
+
+  void _prefetch()
+  {
+#if defined(POSIX_FADV_WILLNEED)
+    if(_file_pos >= 0)
+      posix_fadvise(_fd, _file_pos, _readahead, POSIX_FADV_WILLNEED);
+#endif
+  }
+
+  //reads up to max bytes into dest, returning once at least min bytes are read or the
+  //end of the file is reached, so that pipes and sockets do not block for more data
+  //than is needed
+  uintptr_t _readRaw(char* dest, uintptr_t min, uintptr_t max)
+  {
+    uintptr_t total = 0;
+    while(total < min && !_eof)
+    {
+      ssize_t n = ::read(_fd, dest + total, max - total);
+      if(n < 0)
+      {
+        if(errno == EINTR)
+          continue;
+        _good = false;
+        _eof = true;
+      }
+      else if(n == 0)
+        _eof = true;
+      else total += n;
+    }
+    if(_file_pos >= 0)
+      _file_pos += total;
+    return total;
+  }
+
+  uintptr_t _fill(uintptr_t len)
+  {
+    if(_end - _begin >= len || _eof)
+      return _end - _begin;
+    if(len > _capacity)
+    {
+      uintptr_t new_cap = _capacity << 1;
+      while(new_cap < len)
+        new_cap <<= 1;
+      std::unique_ptr<char[]> buffer(new char[new_cap]);
+      memcpy(buffer.get(), _buffer.get() + _begin, _end - _begin);
+      _buffer = std::move(buffer);
+      _capacity = new_cap;
+    }
+    else memmove(_buffer.get(), _buffer.get() + _begin, _end - _begin);
+    _end -= _begin;
+    _begin = 0;
+    _end += _readRaw(_buffer.get() + _end, len - _end, _capacity - _end);
+    _prefetch();
+    return _end - _begin;
+  }
+  const char* _cursor() const
+  {
+    return _buffer.get() + _begin;
+  }
+  void _consume(uintptr_t len)
+  {
+    _begin += len;
+    _consumed += len;
+  }
+
+public:
+  using BinReader<BinStreamReader>::read;
+
+  /**
+    @brief Constructor
+    @param fd File descriptor to read from. It is not closed by the reader.
+    @param buffer_size Size of the read buffer in bytes. default: 1 MiB
+    @param readahead Number of bytes past the buffer the kernel is asked to prefetch.
+    default: 4 MiB
+  */
+  BinStreamReader(int fd, uintptr_t buffer_size = uintptr_t(1) << 20,
+    uintptr_t readahead = uintptr_t(4) << 20):
+    _fd(fd),
+    _capacity(buffer_size < 64? 64 : buffer_size),
+    _readahead(readahead)
+  {
+    _buffer.reset(new char[_capacity]);
+    _file_pos = lseek(fd, 0, SEEK_CUR);
+#if defined(POSIX_FADV_SEQUENTIAL)
+    if(_file_pos >= 0)
+      posix_fadvise(fd, _file_pos, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    _prefetch();
+  }
+  BinStreamReader(const BinStreamReader&) = delete;
+  void operator=(const BinStreamReader&) = delete;
+
+  /**
+    @brief Returns the number of bytes read.
+  */
+  uintptr_t tell() const
+  {
+    return _consumed;
+  }
+
+  /**
+    @brief Returns true if all data has been read.
+  */
+  bool at_end()
+  {
+    return _fill(1) == 0;
+  }
+
+  /**
+    @brief Reads a number of objects.
+    @param out Where to copy the objects.
+    @param len Number of objects to read.
+    @return false if the data ends before all objects are read.
+  */
+  template<class T>
+  bool read(T* out, uintptr_t len)
+  {
+    static_assert(std::is_trivially_copyable<T>::value,
+      "BinStreamReader can only read trivially copyable types");
+    uintptr_t bytes = len * sizeof(T);
+    uintptr_t buffered = _end - _begin < bytes? _end - _begin : bytes;
+    memcpy((void*)out, _cursor(), buffered);
+    _consume(buffered);
+    char* dest = (char*)out + buffered;
+    bytes -= buffered;
+    if(bytes >= _capacity)
+    {
+      uintptr_t n = _readRaw(dest, bytes, bytes);
+      _consumed += n;
+      _prefetch();
+      dest += n;
+      bytes -= n;
+    }
+    else if(bytes > 0 && _fill(bytes) >= bytes)
+    {
+      memcpy(dest, _cursor(), bytes);
+      _consume(bytes);
+      bytes = 0;
+    }
+    if(bytes > 0)
+    {
+      _good = false;
+      return false;
+    }
+    return true;
+  }
+
+  /**
+    @brief Skips a number of bytes.
+    @return false if the data ends first.
+  */
+  bool skip(uintptr_t len)
+  {
+    while(len > 0)
+    {
+      uintptr_t avail = _fill(len < _capacity? len : _capacity);
+      if(avail == 0)
+      {
+        _good = false;
+        return false;
+      }
+      uintptr_t n = avail < len? avail : len;
+      _consume(n);
+      len -= n;
+    }
+    return true;
+  }
+};
+
+#endif
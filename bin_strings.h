@@ -0,0 +1,250 @@
+#ifndef BIN_STRINGS_H_INCLUDED
+#define BIN_STRINGS_H_INCLUDED
+
+/**
+  @file
+  @author Erik Boström <cewbostrom@gmail.com>
+  @date 16.10.2026
+
+  @section LICENSE
+
+  MIT License (MIT)
+
+  Copyright (c) 2015 Erik Boström
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+
+  @section DESCRIPTION
+
+  Interning of strings that repeat. The first time a string is written it is given
+  the next id and written in full, and after that only its id is written as a varint,
+  so a string that is seen a million times costs one or two bytes each time after the
+  first. The reader keeps the strings it has seen in an array indexed by id.
+
+  encoding: a varint that is 0 for a new string, followed by its length as a varint
+  and its bytes, or the id of a string written before plus one.
+
+  The writer finds repeated strings through an open addressing hash table over its
+  own copies of the strings, hashed with bin_crc32c, so writing a string seen before
+  allocates nothing. The table grows with every distinct string; to bound it, start
+  a new writer and reader for each independent piece of data.
+
+  usage:
+
+  BinStringWriter<BinSerializer> strings(serializer);
+  strings.write(name);
+
+  BinStringReader<BinDeserializer> strings(deserializer);
+  const std::string* name = strings.read();
+*/
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+
+#include "bin_serializer.h"
+
+/**
+  @brief Writes strings, each distinct string in full once and as an id after that.
+  @param Out Type of the writer to write to.
+*/
+template<class Out>
+class BinStringWriter
+{
+  struct __Entry
+  {
+    uintptr_t offset;
+    uintptr_t len;
+    uint32_t hash;
+  };
+
+  Out& _out;
+  std::vector<char> _chars;
+  std::vector<__Entry> _strings;
+  std::vector<uint32_t> _slots;
+  uintptr_t _mask = 0;
+
+  void _grow()
+  {
+    uintptr_t size = _slots.empty()? 64 : _slots.size() * 2;
+    _slots.assign(size, 0);
+    _mask = size - 1;
+    for(uint32_t id = 0; id < _strings.size(); ++id)
+    {
+      uintptr_t i = _strings[id].hash & _mask;
+      while(_slots[i] != 0)
+        i = (i + 1) & _mask;
+      _slots[i] = id + 1;
+    }
+  }
+
+public:
+  /**
+    @brief Constructor
+    @param out The writer to write to. It must outlive this object.
+  */
+  explicit BinStringWriter(Out& out):
+    _out(out)
+  {
+    _grow();
+  }
+  BinStringWriter(const BinStringWriter&) = delete;
+  void operator=(const BinStringWriter&) = delete;
+
+  /**
+    @brief Returns the number of distinct strings written.
+  */
+  uintptr_t size() const
+  {
+    return _strings.size();
+  }
+
+  /**
+    @brief Writes a string.
+    @param str Pointer to the characters.
+    @param len Number of characters.
+    @return The id of the string.
+  */
+  uint32_t write(const char* str, uintptr_t len)
+  {
+    uint32_t hash = bin_crc32c(str, len);
+    uintptr_t i = hash & _mask;
+    for(; _slots[i] != 0; i = (i + 1) & _mask)
+    {
+      const __Entry& entry = _strings[_slots[i] - 1];
+      if(entry.hash == hash && entry.len == len
+        && (len == 0 || memcmp(_chars.data() + entry.offset, str, len) == 0))
+      {
+        _out.write_varint(_slots[i]);
+        return _slots[i] - 1;
+      }
+    }
+
+    uint32_t id = uint32_t(_strings.size());
+    __Entry entry = {_chars.size(), len, hash};
+    _chars.insert(_chars.end(), str, str + len);
+    _strings.push_back(entry);
+    _slots[i] = id + 1;
+    if(_strings.size() * 2 > _slots.size())
+      _grow();
+
+    _out.write_varint(0);
+    _out.write_varint(len);
+    _out.write_span(str, len);
+    return id;
+  }
+
+  /**
+    @brief Writes a string.
+    @return The id of the string.
+  */
+  uint32_t write(const std::string& str)
+  {
+    return write(str.data(), str.size());
+  }
+
+  /**
+    @brief Writes a C-style string.
+    @return The id of the string.
+  */
+  uint32_t write(const char* str)
+  {
+    return write(str, strlen(str));
+  }
+};
+
+/**
+  @brief Reads strings written by BinStringWriter.
+  @param In Type of the reader to read from.
+*/
+template<class In>
+class BinStringReader
+{
+  In& _in;
+  std::deque<std::string> _strings;
+
+public:
+  /**
+    @brief Constructor
+    @param in The reader to read from. It must outlive this object.
+  */
+  explicit BinStringReader(In& in):
+    _in(in)
+    {}
+  BinStringReader(const BinStringReader&) = delete;
+  void operator=(const BinStringReader&) = delete;
+
+  /**
+    @brief Returns the number of distinct strings read.
+  */
+  uintptr_t size() const
+  {
+    return _strings.size();
+  }
+
+  /**
+    @brief Returns a string by its id.
+  */
+  const std::string& operator[](uint32_t id) const
+  {
+    return _strings[id];
+  }
+
+  /**
+    @brief Reads a string.
+    @return A pointer to the string, which stays valid as long as this object, or
+    nullptr if the data is truncated or malformed.
+  */
+  const std::string* read()
+  {
+    uint64_t tag = _in.read_varint();
+    if(!_in.good())
+      return nullptr;
+    if(tag != 0)
+      return tag <= _strings.size()? &_strings[uintptr_t(tag - 1)] : nullptr;
+
+    uint64_t len = _in.read_varint();
+    if(!_in.good() || len > uint64_t(uintptr_t(-1)) || !_in.may_contain(uintptr_t(len)))
+      return nullptr;
+    _strings.emplace_back(uintptr_t(len), '\0');
+    if(len != 0 && !_in.read(&_strings.back()[0], uintptr_t(len)))
+    {
+      _strings.pop_back();
+      return nullptr;
+    }
+    return &_strings.back();
+  }
+
+  /**
+    @brief Reads a string into out.
+    @return false if the data is truncated or malformed.
+  */
+  bool read(std::string& out)
+  {
+    const std::string* str = read();
+    if(str == nullptr)
+      return false;
+    out = *str;
+    return true;
+  }
+};
+
+#endif
@@ -40,6 +40,21 @@
 */
 
 #include <new>
+#include <utility>
+#include <type_traits>
+#include <cstdlib>
+#include <cstring>
+
+/**
+  @brief Trait telling CFHeap that objects of type T can be relocated with memcpy.
+  
+  Defaults to std::is_trivially_copyable. Specialize it for types that are not
+  trivially copyable but stay valid when their bytes are moved to a new address (most
+  types that do not hold pointers into themselves) to let CFHeap grow them with
+  realloc instead of move-constructing and destroying each element.
+*/
+template<class T>
+struct cfheap_relocatable: std::is_trivially_copyable<T>{};
 
 /**
   @param T value type
@@ -51,17 +66,44 @@ class CFHeap
   int capacity;
   int _size;
   
-  void allocate_more()
+  typedef std::integral_constant<bool, cfheap_relocatable<T>::value> relocatable;
+  
+  static void relocate_range(T* dest, T* src, int num, std::true_type)
   {
-    capacity <<= 1;
-    capacity += 1;
-    T* temp = static_cast<T*>(::operator new(capacity * sizeof(T)));
-    for(int i = 0; i < _size; ++i)
+    if(num != 0)
+      memcpy((void*)dest, (const void*)src, num * sizeof(T));
+  }
+  static void relocate_range(T* dest, T* src, int num, std::false_type)
+  {
+    for(int i = 0; i < num; ++i)
     {
-      new(temp + i) T(std::move(storage[i]));
+      new(dest + i) T(std::move(src[i]));
+      src[i].~T();
     }
-    delete[] storage;
+  }
+  
+  void reallocate(int new_capacity, std::true_type)
+  {
+    T* temp = static_cast<T*>(std::realloc((void*)storage, new_capacity * sizeof(T)));
+    if(temp == nullptr)
+      throw std::bad_alloc();
     storage = temp;
+    capacity = new_capacity;
+  }
+  void reallocate(int new_capacity, std::false_type)
+  {
+    T* temp = static_cast<T*>(std::malloc(new_capacity * sizeof(T)));
+    if(temp == nullptr)
+      throw std::bad_alloc();
+    relocate_range(temp, storage, _size, std::false_type());
+    std::free(storage);
+    storage = temp;
+    capacity = new_capacity;
+  }
+  
+  void allocate_more()
+  {
+    reallocate((capacity << 1) + 1, relocatable());
   }
   void up_swap()
   {
@@ -77,9 +119,8 @@ class CFHeap
       else break;
     }
   }
-  void down_swap()
+  void down_swap(int idx = 0)
   {
-    int idx = 0;
     do
     {
       int next_idx = ((idx + 1) << 1) - 1;
@@ -94,60 +135,107 @@ class CFHeap
       else break;
     }while(true);
   }
+  void heapify()
+  {
+    for(int idx = (_size >> 1) - 1; idx >= 0; --idx)
+      down_swap(idx);
+  }
+  void destroy()
+  {
+    for(int i = 0; i < _size; ++i)
+      storage[i].~T();
+    std::free(storage);
+  }
+  void copy_from(const CFHeap<T>& other)
+  {
+    capacity = other.capacity;
+    _size = other._size;
+    storage = static_cast<T*>(std::malloc(capacity * sizeof(T)));
+    if(storage == nullptr && capacity != 0)
+      throw std::bad_alloc();
+    for(int i = 0; i < _size; ++i)
+      new(storage + i) T(other.storage[i]);
+  }
   
 public:
 
   CFHeap()
   {
-    storage = static_cast<T*>(::operator new(15 * sizeof(T)));
+    storage = static_cast<T*>(std::malloc(15 * sizeof(T)));
+    if(storage == nullptr)
+      throw std::bad_alloc();
+    capacity = 15;
+    _size = 0;
+  }
+  /**
+    @brief Builds a heap from a range of elements in linear time.
+    @param begin Iterator to the first element in the range.
+    @param end Iterator past the end of the range.
+    @note It must be at least a forward iterator since the range is traversed twice.
+  */
+  template<class It>
+  CFHeap(It begin, It end)
+  {
     capacity = 15;
     _size = 0;
+    for(It it = begin; it != end; ++it)
+      ++_size;
+    while(capacity < _size)
+      capacity = (capacity << 1) + 1;
+    storage = static_cast<T*>(std::malloc(capacity * sizeof(T)));
+    if(storage == nullptr)
+      throw std::bad_alloc();
+    for(int i = 0; begin != end; ++begin, ++i)
+      new(storage + i) T(*begin);
+    heapify();
   }
   CFHeap(const CFHeap<T>& other)
   {
-    capacity = other.capacity;
-    _size = other._size;
-    storage = static_cast<T*>(::operator new(capacity * sizeof(T)));
-    for(int i = 0; i < _size; ++i)
-      new(storage + i) T(other.storage[i]);
+    copy_from(other);
   }
   CFHeap(CFHeap<T>&& other)
   {
     capacity = other.capacity;
-    _size = other.size;
+    _size = other._size;
     storage = other.storage;
     other.storage = nullptr;
+    other.capacity = 0;
     other._size = 0;
   }
   ~CFHeap()
   {
-    for(int i = 0; i < _size; ++i)
-      storage[i].~T();
-    ::operator delete(storage);
+    destroy();
   }
 
   CFHeap<T>& operator=(const CFHeap<T>& other)
   {
-    for(int i = 0; i < _size; ++i)
-      storage[i].~T();
-    ::operator delete(storage);
-    capacity = other.capacity;
-    _size = other._size;
-    storage = static_cast<T*>(::operator new(capacity * sizeof(T)));
-    for(int i = 0; i < _size; ++i)
-      new(storage + i) T(other.storage[i]);
+    if(this == &other)
+      return *this;
+    destroy();
+    copy_from(other);
     return *this;
   }
   CFHeap<T>& operator=(CFHeap<T>&& other)
   {
-    for(int i = 0; i < _size; ++i)
-      storage[i].~T();
-    ::operator delete(storage);
+    if(this == &other)
+      return *this;
+    destroy();
     capacity = other.capacity;
     _size = other._size;
     storage = other.storage;
     other.storage = nullptr;
+    other.capacity = 0;
     other._size = 0;
+    return *this;
+  }
+  
+  /**
+    @brief Reserves room for at least new_capacity elements.
+  */
+  void reserve(int new_capacity)
+  {
+    if(new_capacity > capacity)
+      reallocate(new_capacity, relocatable());
   }
   
   void push(const T& element)
@@ -162,16 +250,16 @@ public:
   {
     if(_size == capacity)
       allocate_more();
-    new(storage + _size) T(element);
+    new(storage + _size) T(std::move(element));
     up_swap();
     ++_size;
   }
   void pop()
   {
-    storage->~T();
-    new(storage) T(std::move(storage[_size - 1]));
-    storage[_size - 1].~T();
     --_size;
+    if(_size != 0)
+      *storage = std::move(storage[_size]);
+    storage[_size].~T();
     down_swap();
   }
   template<class... Args>
@@ -179,10 +267,61 @@ public:
   {
     if(_size == capacity)
       allocate_more();
-    new(storage) T(std::forward<Args>(args)...);
+    new(storage + _size) T(std::forward<Args>(args)...);
     up_swap();
     ++_size;
   }
+  /**
+    @brief Melds another heap into this one.
+    
+    The elements of other are appended to the buffer in one go and the heap order is
+    restored afterwards, by sifting the appended elements up when that takes fewer
+    steps than rebuilding the whole heap in linear time, and by rebuilding otherwise.
+    other is left empty.
+  */
+  void merge(CFHeap<T>&& other)
+  {
+    if(this == &other || other._size == 0)
+      return;
+    if(other._size > _size)
+      swap(other);
+    
+    int old_size = _size;
+    int new_size = _size + other._size;
+    if(new_size > capacity)
+    {
+      int new_capacity = capacity;
+      while(new_capacity < new_size)
+        new_capacity = (new_capacity << 1) + 1;
+      reallocate(new_capacity, relocatable());
+    }
+    relocate_range(storage + old_size, other.storage, other._size, relocatable());
+    other._size = 0;
+    
+    //sifting k elements up costs up to k * log2(n) swaps, rebuilding costs about n
+    int depth = 0;
+    for(int n = new_size; n > 1; n >>= 1)
+      ++depth;
+    if((long long)(new_size - old_size) * depth < new_size)
+    {
+      for(_size = old_size; _size < new_size; ++_size)
+        up_swap();
+    }
+    else
+    {
+      _size = new_size;
+      heapify();
+    }
+  }
+  /**
+    @brief Restores the heap order after the top element has been modified in place.
+    
+    Cheaper than a pop followed by a push when the top element is to be replaced.
+  */
+  void update_top()
+  {
+    down_swap();
+  }
   void swap(CFHeap<T>& other)
   {
     int cap = capacity;
@@ -0,0 +1,388 @@
+#ifndef EXTERNAL_HEAP_H_INCLUDED
+#define EXTERNAL_HEAP_H_INCLUDED
+
+/**
+  @file
+  @author Erik Boström <cewbostrom@gmail.com>
+  @date 16.10.2026
+
+  @section LICENSE
+
+  MIT License (MIT)
+
+  Copyright (c) 2015 Erik Boström
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+
+  @section DESCRIPTION
+
+  A priority queue that spills to disk when it outgrows a memory budget.
+
+  New elements go into an in-memory CFHeap. When that heap reaches its share of the
+  budget it is drained in order into a sorted run in a temporary file. Runs are read
+  back one block at a time and merged lazily as elements are popped, so the hot head
+  of the queue is served from memory and all file I/O is sequential within a run.
+
+  usage:
+
+  pretty much the same as std::priority_queue, the greatest element is on top.
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+#include <type_traits>
+
+#include "cfheap.h"
+
+/**
+  @brief Priority queue with bounded memory that spills sorted runs to a temporary file.
+  @param T value type. Must be trivially copyable since elements are written to and
+  read from the file as raw bytes.
+*/
+template<class T>
+class ExternalHeap
+{
+  static_assert(std::is_trivially_copyable<T>::value,
+    "ExternalHeap requires a trivially copyable value type");
+
+  struct __Block
+  {
+    T* data;
+
+    __Block(): data(nullptr){}
+    explicit __Block(size_t n): data(static_cast<T*>(::operator new(n * sizeof(T)))){}
+    __Block(const __Block&) = delete;
+    void operator=(const __Block&) = delete;
+    ~__Block(){::operator delete(data);}
+
+    void release()
+    {
+      ::operator delete(data);
+      data = nullptr;
+    }
+  };
+
+  struct __Run
+  {
+    long offset;       //file offset of the first element not yet read
+    size_t remaining;  //elements left in the file
+    size_t block;      //elements read at a time
+    __Block buffer;
+    size_t pos = 0;
+    size_t count = 0;
+
+    __Run(long o, size_t n, size_t b): offset(o), remaining(n), block(b), buffer(b){}
+
+    const T& head() const
+    {return buffer.data[pos];}
+  };
+
+  struct __RunRef
+  {
+    __Run* run;
+
+    bool operator<(const __RunRef& other) const
+    {return run->head() < other.run->head();}
+    bool operator>(const __RunRef& other) const
+    {return run->head() > other.run->head();}
+  };
+
+  CFHeap<T> _buffer;
+  CFHeap<__RunRef> _run_heap;
+  std::vector<std::unique_ptr<__Run>> _runs;
+  std::FILE* _file = nullptr;
+  long _file_end = 0;
+  bool _spill_failed = false;
+  bool _read_failed = false;
+
+  size_t _size = 0;
+  size_t _buffer_limit;
+  size_t _block_elements;
+  size_t _max_runs;
+
+  static std::FILE* _openTemp()
+  {
+    std::FILE* f = std::tmpfile();
+    if(f != nullptr)
+      std::setvbuf(f, nullptr, _IONBF, 0);
+    return f;
+  }
+
+  //reads the next block of a run. Returns false when the run is exhausted or, with
+  //run.remaining left non-zero, when reading fails
+  bool _refill(__Run& run)
+  {
+    if(run.remaining == 0)
+      return false;
+    size_t n = run.remaining < run.block? run.remaining : run.block;
+    if(std::fseek(_file, run.offset, SEEK_SET) != 0
+      || std::fread(run.buffer.data, sizeof(T), n, _file) != n)
+      return false;
+    run.offset += long(n * sizeof(T));
+    run.remaining -= n;
+    run.pos = 0;
+    run.count = n;
+    return true;
+  }
+
+  //drops the unread elements of a run that could not be read back
+  void _lose(__Run& run)
+  {
+    _size -= run.remaining;
+    run.remaining = 0;
+    _read_failed = true;
+  }
+
+  //advances the run on top of the run heap
+  void _advanceTop()
+  {
+    __Run& run = *_run_heap.top().run;
+    if(++run.pos == run.count && !_refill(run))
+    {
+      if(run.remaining != 0)
+        _lose(run);
+      run.buffer.release();
+      _run_heap.pop();
+      if(_run_heap.empty())
+      {
+        //every run has been consumed, the file can be reused from the start
+        _runs.clear();
+        _file_end = 0;
+      }
+    }
+    else _run_heap.update_top();
+  }
+
+  //merges all live runs into a single run in a new file. The runs are read through
+  //cursors of their own, so that if anything fails the old file and runs are kept
+  bool _compact()
+  {
+    std::FILE* file = _openTemp();
+    if(file == nullptr)
+      return false;
+
+    //the cursors share one block between them
+    size_t block = _block_elements / (size_t)_run_heap.size();
+    if(block == 0) block = 1;
+    std::vector<std::unique_ptr<__Run>> cursors;
+    CFHeap<__RunRef> merge;
+    size_t total = 0;
+    bool ok = true;
+    for(size_t i = 0; i < _runs.size() && ok; ++i)
+    {
+      __Run& run = *_runs[i];
+      if(run.buffer.data == nullptr)
+        continue;
+      //the unread part of the buffer lies right before run.offset in the file
+      size_t buffered = run.count - run.pos;
+      cursors.emplace_back(new __Run(run.offset - long(buffered * sizeof(T)),
+        run.remaining + buffered, block));
+      total += run.remaining + buffered;
+      ok = _refill(*cursors.back());
+      if(ok)
+        merge.push(__RunRef{cursors.back().get()});
+    }
+
+    __Block out(_block_elements);
+    size_t filled = 0;
+    while(ok && !merge.empty())
+    {
+      __Run& cursor = *merge.top().run;
+      out.data[filled++] = cursor.head();
+      if(filled == _block_elements)
+      {
+        ok = std::fwrite(out.data, sizeof(T), filled, file) == filled;
+        filled = 0;
+      }
+      if(++cursor.pos == cursor.count && !_refill(cursor))
+      {
+        ok = ok && cursor.remaining == 0;
+        merge.pop();
+      }
+      else merge.update_top();
+    }
+    ok = ok && std::fwrite(out.data, sizeof(T), filled, file) == filled;
+    if(!ok)
+    {
+      std::fclose(file);
+      return false;
+    }
+
+    std::fclose(_file);
+    _file = file;
+    _run_heap = CFHeap<__RunRef>();
+    _runs.clear();
+    _file_end = long(total * sizeof(T));
+    _addRun(0, total);
+    return true;
+  }
+
+  void _addRun(long offset, size_t count)
+  {
+    _runs.emplace_back(new __Run(offset, count, _block_elements));
+    __Run* run = _runs.back().get();
+    if(_refill(*run))
+      _run_heap.push(__RunRef{run});
+    else
+    {
+      if(run->remaining != 0)
+        _lose(*run);
+      run->buffer.release();
+    }
+  }
+
+  void _spill()
+  {
+    if(_file == nullptr && (_file = _openTemp()) == nullptr)
+    {
+      _spill_failed = true;
+      return;
+    }
+    //only live runs count, exhausted ones are dropped here
+    _runs.erase(std::remove_if(_runs.begin(), _runs.end(),
+      [](const std::unique_ptr<__Run>& run){return run->buffer.data == nullptr;}), _runs.end());
+    if((size_t)_run_heap.size() >= _max_runs && !_compact())
+    {
+      _spill_failed = true;
+      return;
+    }
+
+    long offset = _file_end;
+    size_t count = 0;
+    __Block out(_block_elements);
+    size_t filled = 0;
+    if(std::fseek(_file, offset, SEEK_SET) != 0)
+    {
+      _spill_failed = true;
+      return;
+    }
+    while(!_buffer.empty())
+    {
+      out.data[filled++] = _buffer.top();
+      _buffer.pop();
+      ++count;
+      if(filled == _block_elements || _buffer.empty())
+      {
+        if(std::fwrite(out.data, sizeof(T), filled, _file) != filled)
+        {
+          //put back what has not been written and give up spilling
+          for(size_t i = 0; i < filled; ++i)
+            _buffer.push(out.data[i]);
+          count -= filled;
+          _spill_failed = true;
+          break;
+        }
+        filled = 0;
+      }
+    }
+    _file_end = offset + long(count * sizeof(T));
+    if(count != 0)
+      _addRun(offset, count);
+  }
+
+  bool _topInRuns()
+  {
+    if(_run_heap.empty()) return false;
+    if(_buffer.empty()) return true;
+    return _buffer.top() < _run_heap.top().run->head();
+  }
+
+public:
+
+  /**
+    @brief Constructor
+    @param memory_budget Approximate number of bytes the queue may keep in memory.
+    Half of it is used for the in-memory heap, the other half for the read buffers of
+    the runs on disk. default: 64 MiB
+    @param block_size Size in bytes of the blocks runs are read in. default: 64 KiB
+  */
+  ExternalHeap(size_t memory_budget = size_t(64) << 20, size_t block_size = size_t(64) << 10)
+  {
+    size_t half = memory_budget >> 1;
+    _buffer_limit = half / sizeof(T);
+    if(_buffer_limit == 0) _buffer_limit = 1;
+    _block_elements = block_size / sizeof(T);
+    if(_block_elements == 0) _block_elements = 1;
+    _max_runs = half / (_block_elements * sizeof(T));
+    if(_max_runs < 2) _max_runs = 2;
+  }
+  ExternalHeap(const ExternalHeap&) = delete;
+  void operator=(const ExternalHeap&) = delete;
+  ~ExternalHeap()
+  {
+    if(_file != nullptr)
+      std::fclose(_file);
+  }
+
+  void push(const T& element)
+  {
+    if(!_spill_failed && (size_t)_buffer.size() >= _buffer_limit)
+      _spill();
+    _buffer.push(element);
+    ++_size;
+  }
+
+  const T& top()
+  {
+    if(_topInRuns())
+      return _run_heap.top().run->head();
+    return _buffer.top();
+  }
+
+  void pop()
+  {
+    if(_topInRuns())
+      _advanceTop();
+    else _buffer.pop();
+    --_size;
+  }
+
+  bool empty()
+  {
+    return _size == 0;
+  }
+  size_t size()
+  {
+    return _size;
+  }
+
+  /**
+    @brief Number of runs currently stored on disk.
+  */
+  size_t runs()
+  {
+    return _run_heap.size();
+  }
+
+  /**
+    @brief Returns false if spilling to disk has failed, in which case the queue keeps
+    growing in memory instead, or if reading a run back has failed, in which case the
+    elements left in that run are lost and no longer counted by size().
+  */
+  bool good()
+  {
+    return !_spill_failed && !_read_failed;
+  }
+};
+
+#endif
@@ -0,0 +1,221 @@
+#ifndef KWAY_MERGE_H_INCLUDED
+#define KWAY_MERGE_H_INCLUDED
+
+/**
+  @file
+  @author Erik Boström <cewbostrom@gmail.com>
+  @date 16.10.2026
+
+  @section LICENSE
+
+  MIT License (MIT)
+
+  Copyright (c) 2015 Erik Boström
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+
+  @section DESCRIPTION
+
+  K-way merge of sorted ranges. The heads of the ranges are kept in a CFHeap, so the
+  merge state lives in one contiguous buffer and each produced element costs a single
+  sift-down.
+
+  usage:
+
+  add any number of ranges sorted in ascending order with add(), then either iterate
+  over the merge with begin()/end(), pull elements one at a time with next(), or pull
+  them in batches with next_n().
+*/
+
+#include <iterator>
+#include <utility>
+
+#include "cfheap.h"
+
+/**
+  @brief Merges any number of sorted ranges into one sorted sequence.
+
+  Elements are compared with operator<. Equal elements are produced in the order their
+  ranges were added.
+
+  @param It iterator type of the ranges. Must at least be an input iterator.
+*/
+template<class It>
+class KWayMerge
+{
+public:
+
+  typedef typename std::iterator_traits<It>::value_type value_type;
+  typedef typename std::iterator_traits<It>::reference reference;
+
+private:
+
+  struct __Run
+  {
+    It pos;
+    It end;
+    int index;
+
+    __Run(It b, It e, int i): pos(b), end(e), index(i){}
+
+    static bool __before(const __Run& a, const __Run& b)
+    {
+      if(*a.pos < *b.pos) return true;
+      if(*b.pos < *a.pos) return false;
+      return a.index < b.index;
+    }
+
+    //CFHeap keeps the greatest element on top, so the run that comes first compares
+    //as the greater one
+    bool operator<(const __Run& other) const
+    {return __before(other, *this);}
+    bool operator>(const __Run& other) const
+    {return __before(*this, other);}
+  };
+
+  CFHeap<__Run> _heap;
+  int _runs = 0;
+
+public:
+
+  /**
+    @brief Input iterator over the remaining elements of the merge.
+
+    Incrementing the iterator consumes an element from the merge.
+  */
+  class iterator
+  {
+    KWayMerge* _obj;
+
+  public:
+    typedef std::input_iterator_tag iterator_category;
+    typedef typename KWayMerge::value_type value_type;
+    typedef typename std::iterator_traits<It>::difference_type difference_type;
+    typedef typename std::iterator_traits<It>::pointer pointer;
+    typedef typename KWayMerge::reference reference;
+
+    iterator(KWayMerge* o = nullptr): _obj(o){}
+
+    reference operator*() const
+    {return _obj->top();}
+    iterator& operator++()
+    {_obj->pop(); return *this;}
+    void operator++(int)
+    {_obj->pop();}
+
+    bool operator==(const iterator& other) const
+    {
+      bool at_end = _obj == nullptr || _obj->empty();
+      bool other_at_end = other._obj == nullptr || other._obj->empty();
+      if(at_end || other_at_end) return at_end == other_at_end;
+      return _obj == other._obj;
+    }
+    bool operator!=(const iterator& other) const
+    {return !(*this == other);}
+  };
+
+  /**
+    @brief Adds a sorted range to the merge.
+    @param begin Iterator to the first element in the range.
+    @param end Iterator past the end of the range.
+  */
+  void add(It begin, It end)
+  {
+    if(begin != end)
+      _heap.emplace(begin, end, _runs);
+    ++_runs;
+  }
+
+  /**
+    @brief Returns a reference to the smallest remaining element.
+    @note The merge must not be empty.
+  */
+  reference top()
+  {
+    return *_heap.top().pos;
+  }
+
+  /**
+    @brief Consumes the smallest remaining element.
+    @note The merge must not be empty.
+  */
+  void pop()
+  {
+    __Run& run = _heap.top();
+    ++run.pos;
+    if(run.pos == run.end)
+      _heap.pop();
+    else _heap.update_top();
+  }
+
+  /**
+    @brief Consumes and returns the smallest remaining element.
+    @note The merge must not be empty.
+  */
+  value_type next()
+  {
+    value_type ret = top();
+    pop();
+    return ret;
+  }
+
+  /**
+    @brief Consumes up to n elements, writing them to out.
+    @param out Output iterator to write the elements to.
+    @param n Maximum number of elements to consume.
+    @return Number of elements written.
+  */
+  template<class OutIt>
+  int next_n(OutIt out, int n)
+  {
+    int written = 0;
+    while(written < n && !_heap.empty())
+    {
+      __Run& run = _heap.top();
+      *out = *run.pos;
+      ++out;
+      ++written;
+      ++run.pos;
+      if(run.pos == run.end)
+        _heap.pop();
+      else _heap.update_top();
+    }
+    return written;
+  }
+
+  bool empty()
+  {
+    return _heap.empty();
+  }
+
+  /**
+    @brief Number of ranges that still have elements left.
+  */
+  int runs()
+  {
+    return _heap.size();
+  }
+
+  iterator begin()
+  {return iterator(this);}
+  iterator end()
+  {return iterator();}
+};
+
+#endif
@@ -41,6 +41,7 @@
 #include <memory>
 #include <new>
 #include <initializer_list>
+#include <utility>
 #include <iostream>
 
 /**
@@ -489,6 +490,32 @@ public:
     return _back % _capacity == _front;
   }
   
+  /**
+    @brief Returns the first of the at most two contiguous arrays the elements are
+    stored in, as a pointer and a number of elements. It holds the front of the
+    container.
+  */
+  std::pair<T*, size_t> array_one() const
+  {
+    size_t n = size();
+    if(n == 0)
+      return std::pair<T*, size_t>(nullptr, 0);
+    size_t to_end = _capacity - _front;
+    return std::pair<T*, size_t>((T*)_buf[_front], n < to_end? n : to_end);
+  }
+  /**
+    @brief Returns the second of the at most two contiguous arrays the elements are
+    stored in. It is empty unless the elements wrap around the end of the buffer.
+  */
+  std::pair<T*, size_t> array_two() const
+  {
+    size_t n = size();
+    size_t first = array_one().second;
+    if(n == first)
+      return std::pair<T*, size_t>(nullptr, 0);
+    return std::pair<T*, size_t>((T*)_buf[0], n - first);
+  }
+  
   /**
     @brief Accesses an element in the container starting from (index 0) the beginner of
     the container.
@@ -643,7 +670,7 @@ public:
     if(_atMaxCapacity())
       _allocateMore();
     else _back = _back % _capacity;
-    new(&_buf[_back]) T(std::forward(args...));
+    new(&_buf[_back]) T(std::forward<Args>(args)...);
     ++_back;
   }
   /**
@@ -657,7 +684,7 @@ public:
       _allocateMore();
     --_front;
     if(_front < 0) _front = _capacity - 1;
-    new(&_buf[_front]) T(std::forward(args...));
+    new(&_buf[_front]) T(std::forward<Args>(args)...);
   }
   
   /**
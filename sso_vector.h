@@ -147,7 +147,7 @@ private:
     if(_size > Size) return _lBuff();
     else return _sBuff();
   }
-  Type* _activeBuffer() const
+  const Type* _activeBuffer() const
   {
     if(_size > Size) return _lBuff();
     else return _sBuff();
@@ -637,6 +637,37 @@ public:
     _size = 0;
   }
   
+  /**
+    @brief Resizes the container, value initializing new elements. Growing past the
+    capacity allocates room for exactly new_size elements.
+  */
+  void resize(size_t new_size)
+  {
+    while(_size > new_size)
+      pop_back();
+    if(_size == new_size)
+      return;
+    
+    if(new_size > capacity())
+    {
+      char* buffer = new char[sizeof(Type) * new_size];
+      Type* old = _activeBuffer();
+      for(size_t i = 0; i < _size; ++i)
+      {
+        new(buffer + sizeof(Type) * i) Type(std::move(old[i]));
+        old[i].~Type();
+      }
+      if(_size > Size)
+        delete[] _ls_buffer.buffer;
+      _ls_buffer.buffer = buffer;
+      _ls_buffer.capacity = new_size;
+    }
+
+    Type* buffer = new_size > Size? _lBuff() : _sBuff();
+    for(; _size < new_size; ++_size)
+      new(buffer + _size) Type();
+  }
+  
   void push_back(const Type& val)
   {
     if(_size == Size)
@@ -0,0 +1,285 @@
+#ifndef TIMER_WHEEL_H_INCLUDED
+#define TIMER_WHEEL_H_INCLUDED
+
+/**
+  @file
+  @author Erik Boström <cewbostrom@gmail.com>
+  @date 16.10.2026
+
+  @section LICENSE
+
+  MIT License (MIT)
+
+  Copyright (c) 2015 Erik Boström
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+
+  @section DESCRIPTION
+
+  A hierarchical timing wheel. Scheduling and cancelling a timer are O(1) and do not
+  allocate, since timers are linked into the wheel through an intrusive node.
+
+  Each level of the wheel has 2^Bits slots and covers 2^Bits times the range of the
+  level below it. Timers are placed on the lowest level whose range contains their
+  deadline and cascade down one level at a time as the wheel turns. Deadlines beyond
+  the range of the top level go into an overflow list, with a CFHeap of their
+  deadlines telling when the list has to be scanned for timers coming into range.
+
+  usage:
+
+  declare a TimerNode member in the class to be scheduled, then schedule objects with
+  schedule() and drive the wheel with advance(), which calls a function object for
+  every timer that expires.
+*/
+
+#include <cstdint>
+
+#include "intrusive_list.h"
+#include "cfheap.h"
+
+/**
+  @brief Node struct for TimerWheel.
+
+  Declare a member of this type in a class to make it schedulable. A timer that is
+  destroyed while scheduled is removed from the wheel.
+*/
+struct TimerNode
+{
+  IntrusiveNode link;
+  uint64_t deadline = 0;
+
+  /**
+    @brief Returns true if the timer is currently scheduled.
+  */
+  bool scheduled() const
+  {
+    return link.next != &link;
+  }
+};
+
+/**
+  @brief Hierarchical timing wheel.
+  @param Y class containing the timer node
+  @param N member pointer to the timer node
+  @param T value type. Must be derived from Y. Default: Y
+  @param Bits log2 of the number of slots per level. default: 8
+  @param Levels number of levels. Deadlines up to 2^(Bits * Levels) ticks ahead are
+  kept in the wheel itself. default: 4
+*/
+template<class Y, TimerNode Y::*N, class T = Y, unsigned Bits = 8, unsigned Levels = 4>
+class TimerWheel
+{
+  static_assert(Bits * Levels < 64, "TimerWheel range must fit in 64 bits");
+
+  static const unsigned _slots = 1u << Bits;
+  static const uint64_t _mask = _slots - 1;
+
+  IntrusiveNode _wheel[Levels][_slots];
+  IntrusiveNode _overflow;
+  //deadlines are stored inverted since CFHeap keeps the greatest element on top
+  CFHeap<uint64_t> _overflow_deadlines;
+  int _overflow_limit = 64;
+  uint64_t _now;
+
+  static uintptr_t offset()
+  {
+    return member_offset<T, Y>(N);
+  }
+  static TimerNode& _node(T& obj)
+  {
+    return obj.*N;
+  }
+  static T& _object(IntrusiveNode* link)
+  {
+    //link is the first member of TimerNode
+    return *(T*)((char*)link - offset());
+  }
+
+  static void _detach(IntrusiveNode& link)
+  {
+    link.unlink();
+    link.next = &link;
+    link.previous = &link;
+  }
+
+  void _insert(TimerNode& node)
+  {
+    uint64_t when = node.deadline;
+    for(unsigned level = 0; level < Levels; ++level)
+    {
+      unsigned shift = Bits * (level + 1);
+      if((when >> shift) == (_now >> shift))
+      {
+        node.link.linkTo(*_wheel[level][(when >> (Bits * level)) & _mask].previous);
+        return;
+      }
+    }
+    node.link.linkTo(*_overflow.previous);
+    _overflow_deadlines.push(~when);
+    if(_overflow_deadlines.size() > _overflow_limit)
+      _rebuildOverflowDeadlines();
+  }
+
+  //cancelled timers leave their deadlines behind in the heap, so it is rebuilt from
+  //the overflow list whenever it has doubled in size
+  void _rebuildOverflowDeadlines()
+  {
+    CFHeap<uint64_t> deadlines;
+    for(IntrusiveNode* link = _overflow.next; link != &_overflow; link = link->next)
+      deadlines.push(~((TimerNode*)link)->deadline);
+    _overflow_deadlines.swap(deadlines);
+    _overflow_limit = 2 * _overflow_deadlines.size() + 64;
+  }
+
+  void _cascade(IntrusiveNode& slot)
+  {
+    while(slot.next != &slot)
+    {
+      TimerNode& node = *(TimerNode*)slot.next;
+      _detach(node.link);
+      _insert(node);
+    }
+  }
+
+  void _migrateOverflow()
+  {
+    const unsigned shift = Bits * Levels;
+    bool in_range = false;
+    while(!_overflow_deadlines.empty()
+      && (~_overflow_deadlines.top() >> shift) <= (_now >> shift))
+    {
+      _overflow_deadlines.pop();
+      in_range = true;
+    }
+    if(!in_range)
+      return;
+
+    IntrusiveNode* link = _overflow.next;
+    while(link != &_overflow)
+    {
+      IntrusiveNode* next = link->next;
+      TimerNode& node = *(TimerNode*)link;
+      if((node.deadline >> shift) <= (_now >> shift))
+      {
+        _detach(node.link);
+        _insert(node);
+      }
+      link = next;
+    }
+  }
+
+public:
+
+  /**
+    @brief Constructor
+    @param now Tick the wheel starts at. default: 0
+  */
+  TimerWheel(uint64_t now = 0): _now(now){}
+  TimerWheel(const TimerWheel&) = delete;
+  void operator=(const TimerWheel&) = delete;
+  ~TimerWheel()
+  {
+    for(auto& level: _wheel)
+      for(auto& slot: level)
+        while(slot.next != &slot)
+          _detach(*slot.next);
+    while(_overflow.next != &_overflow)
+      _detach(*_overflow.next);
+  }
+
+  /**
+    @brief Schedules a timer. If the timer is already scheduled it is rescheduled.
+    @param obj Object to schedule.
+    @param deadline Tick at which the timer expires. Deadlines that are not in the
+    future are moved to the next tick.
+  */
+  void schedule(T& obj, uint64_t deadline)
+  {
+    TimerNode& node = _node(obj);
+    _detach(node.link);
+    node.deadline = deadline > _now? deadline : _now + 1;
+    _insert(node);
+  }
+
+  /**
+    @brief Cancels a timer. Does nothing if the timer is not scheduled.
+  */
+  void cancel(T& obj)
+  {
+    _detach(_node(obj).link);
+  }
+
+  /**
+    @brief Advances the wheel tick by tick, calling on_expire for every timer that
+    expires.
+
+    Timers are unscheduled before on_expire is called, so they can be rescheduled from
+    within it. Timers expiring on the same tick are reported in the order they were
+    scheduled, or in the order they cascaded into the lowest level.
+
+    @param ticks Number of ticks to advance.
+    @param on_expire Function object called with a reference to each expired object.
+  */
+  template<class F>
+  void advance(uint64_t ticks, F on_expire)
+  {
+    for(uint64_t t = 0; t < ticks; ++t)
+    {
+      ++_now;
+      if((_now & _mask) == 0)
+      {
+        unsigned top = 1;
+        while(top < Levels && ((_now >> (Bits * top)) & _mask) == 0)
+          ++top;
+        if(top == Levels)
+          _migrateOverflow();
+        for(unsigned level = top < Levels? top : Levels - 1; level > 0; --level)
+          _cascade(_wheel[level][(_now >> (Bits * level)) & _mask]);
+      }
+
+      IntrusiveNode& slot = _wheel[0][_now & _mask];
+      while(slot.next != &slot)
+      {
+        IntrusiveNode* link = slot.next;
+        _detach(*link);
+        on_expire(_object(link));
+      }
+    }
+  }
+
+  /**
+    @brief Advances the wheel up to and including the given tick.
+  */
+  template<class F>
+  void advance_to(uint64_t tick, F on_expire)
+  {
+    if(tick > _now)
+      advance(tick - _now, on_expire);
+  }
+
+  /**
+    @brief Returns the current tick.
+  */
+  uint64_t now() const
+  {
+    return _now;
+  }
+};
+
+#endif